@@ -0,0 +1,475 @@
+#include "DedupStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Suduko {
+
+    namespace {
+
+        const char Magic[8] = { 'S', 'U', 'D', 'D', 'E', 'D', 'U', 'P' };
+        const uint32_t Version = 1;
+
+        static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Slots are mapped as atomics.");
+
+        // Search state for finding the smallest transform of a puzzle.
+        struct Canonical {
+            const uint8_t * grid;
+            int colMap[9];
+            uint8_t best[81];
+            int validRows;
+        };
+
+        // Places rows in output order, trying every row the band structure
+        // allows at each depth. Rows are compared with the best grid so far as
+        // they are built and a branch stops at the first cell that is larger.
+        void placeRows(Canonical & search, int depth, int usedBands, int band, int usedRows, const uint8_t * labels, int nextLabel) {
+            if (depth == 9) {
+                return;
+            }
+
+            for (int rowNo = 0; rowNo < 9; rowNo++) {
+                // The first row of each output band opens a new band, the
+                // other two stay in the band of the row before them.
+                bool allowed = (depth % 3 == 0) ? (usedBands & (1 << (rowNo / 3))) == 0 : rowNo / 3 == band;
+                if (!allowed || (usedRows & (1 << rowNo))) {
+                    continue;
+                }
+
+                uint8_t rowLabels[10];
+                std::memcpy(rowLabels, labels, sizeof(rowLabels));
+                int rowNextLabel = nextLabel;
+                uint8_t * bestRow = search.best + depth * 9;
+                bool compare = depth < search.validRows;
+                bool larger = false;
+                bool smaller = false;
+                uint8_t row[9];
+
+                for (int colNo = 0; colNo < 9; colNo++) {
+                    uint8_t value = search.grid[rowNo * 9 + search.colMap[colNo]];
+                    if (value != 0) {
+                        if (rowLabels[value] == 0) {
+                            rowLabels[value] = ++rowNextLabel;
+                        }
+                        value = rowLabels[value];
+                    }
+                    row[colNo] = value;
+                    if (compare && !smaller) {
+                        if (value > bestRow[colNo]) {
+                            larger = true;
+                            break;
+                        }
+                        smaller = value < bestRow[colNo];
+                    }
+                }
+                if (larger) {
+                    continue;
+                }
+                if (!compare || smaller) {
+                    // A new best prefix, the rows after it are no longer valid.
+                    std::memcpy(bestRow, row, 9);
+                    search.validRows = depth + 1;
+                }
+                placeRows(search, depth + 1, usedBands | (1 << (rowNo / 3)), rowNo / 3, usedRows | (1 << rowNo), rowLabels, rowNextLabel);
+            }
+        }
+
+        // Linear probing insert. Returns false if the fingerprint was
+        // already in the table.
+        bool insertSlot(std::atomic<uint64_t> * slots, uint64_t capacity, uint64_t fingerprint) {
+            uint64_t mask = capacity - 1;
+            for (uint64_t probe = 0, index = fingerprint & mask; probe < capacity; probe++, index = (index + 1) & mask) {
+                uint64_t current = slots[index].load(std::memory_order_acquire);
+                while (current == 0) {
+                    if (slots[index].compare_exchange_weak(current, fingerprint, std::memory_order_acq_rel)) {
+                        return true;
+                    }
+                }
+                if (current == fingerprint) {
+                    return false;
+                }
+            }
+            throw std::runtime_error("Dedup store is full.");
+        }
+
+        void replaceFile(const std::string & from, const std::string & to) {
+#ifdef _WIN32
+            if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+                throw std::runtime_error(std::string("Could not replace file: ") + to);
+            }
+#else
+            if (std::rename(from.c_str(), to.c_str()) != 0) {
+                throw std::runtime_error(std::string("Could not replace file: ") + to);
+            }
+#endif
+        }
+    }
+
+    void canonicalForm(const uint8_t * puzzle, const Layout & layout, uint8_t * canonical) {
+        if (!layout.isStandard()) {
+            uint8_t labels[10] = {};
+            int nextLabel = 0;
+            for (int cellId = 0; cellId < 81; cellId++) {
+                uint8_t value = puzzle[cellId];
+                if (value != 0 && labels[value] == 0) {
+                    labels[value] = ++nextLabel;
+                }
+                canonical[cellId] = labels[value];
+            }
+            return;
+        }
+
+        static const int perms[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+        uint8_t transposed[81];
+        for (int cellId = 0; cellId < 81; cellId++) {
+            transposed[cellId] = puzzle[(cellId % 9) * 9 + cellId / 9];
+        }
+
+        Canonical search;
+        search.validRows = 0;
+        const uint8_t noLabels[10] = {};
+        for (int transpose = 0; transpose < 2; transpose++) {
+            search.grid = transpose ? transposed : puzzle;
+            for (int stacks = 0; stacks < 6; stacks++) {
+                for (int cols0 = 0; cols0 < 6; cols0++) {
+                    for (int cols1 = 0; cols1 < 6; cols1++) {
+                        for (int cols2 = 0; cols2 < 6; cols2++) {
+                            const int colPerms[3] = { cols0, cols1, cols2 };
+                            for (int colNo = 0; colNo < 9; colNo++) {
+                                int stack = perms[stacks][colNo / 3];
+                                search.colMap[colNo] = stack * 3 + perms[colPerms[colNo / 3]][colNo % 3];
+                            }
+                            placeRows(search, 0, 0, 0, 0, noLabels, 0);
+                        }
+                    }
+                }
+            }
+        }
+        std::memcpy(canonical, search.best, 81);
+    }
+
+    uint64_t fingerprint(const uint8_t * puzzle, const Layout & layout) {
+        uint8_t canonical[81];
+        canonicalForm(puzzle, layout, canonical);
+
+        // FNV-1a followed by a final mix so the low bits index well.
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto value : canonical) {
+            hash = (hash ^ value) * 1099511628211ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return (hash == 0) ? 1 : hash;
+    }
+
+    //========================================================================
+    // Class: DedupStore
+    //========================================================================
+
+    DedupStore::DedupStore(const std::string & filePath, uint64_t reserve) :
+        m_path(filePath),
+        m_header(nullptr),
+        m_slots(nullptr),
+        m_count(nullptr)
+    {
+        try {
+            lock();
+            open(reserve);
+        }
+        catch (...) {
+            close();
+            unlock();
+            throw;
+        }
+    }
+
+    DedupStore::~DedupStore() {
+        close();
+        unlock();
+    }
+
+    bool DedupStore::contains(uint64_t fingerprint) {
+        uint64_t mask = m_header->capacity - 1;
+        for (uint64_t probe = 0, index = fingerprint & mask; probe < m_header->capacity; probe++, index = (index + 1) & mask) {
+            uint64_t current = m_slots[index].load(std::memory_order_acquire);
+            if (current == fingerprint) {
+                return true;
+            }
+            if (current == 0) {
+                break;
+            }
+        }
+        return false;
+    }
+
+    bool DedupStore::insert(uint64_t fingerprint) {
+        if (!insertSlot(m_slots, m_header->capacity, fingerprint)) {
+            return false;
+        }
+        m_count->fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    uint64_t DedupStore::size() {
+        return m_count->load(std::memory_order_relaxed);
+    }
+
+    uint64_t DedupStore::capacity() {
+        return m_header->capacity;
+    }
+
+    void DedupStore::flush() {
+        flushMapping(m_mapping);
+    }
+
+    void DedupStore::open(uint64_t reserve) {
+        // A temporary file left behind means a crash while growing, as no
+        // other process holds the lock. The original is still complete, so
+        // the partial copy is dropped.
+        std::string tempPath = m_path + ".tmp";
+        std::remove(tempPath.c_str());
+
+        FILE * existing = fopen(m_path.c_str(), "rb");
+        if (existing != nullptr) {
+            fclose(existing);
+        }
+        else {
+            // Build the empty table under a temporary name so a crash never
+            // leaves a store without its header.
+            uint64_t slots = 1024;
+            while (slots < reserve) {
+                slots *= 2;
+            }
+            Mapping created = mapFile(tempPath, sizeof(Header) + slots * sizeof(uint64_t));
+            Header * header = static_cast<Header *>(created.data);
+            std::memcpy(header->magic, Magic, sizeof(Magic));
+            header->version = Version;
+            header->capacity = slots;
+            flushMapping(created);
+            unmapFile(created);
+            replaceFile(tempPath, m_path);
+        }
+        attach();
+
+        // Keep the load below 70% so probe sequences stay short.
+        uint64_t capacity = m_header->capacity;
+        while ((m_count->load() + reserve) * 10 > capacity * 7) {
+            capacity *= 2;
+        }
+        if (capacity != m_header->capacity) {
+            grow(capacity);
+        }
+    }
+
+    void DedupStore::attach() {
+        m_mapping = mapFile(m_path, 0);
+        m_header = static_cast<Header *>(m_mapping.data);
+        if (m_mapping.size < sizeof(Header)
+            || std::memcmp(m_header->magic, Magic, sizeof(Magic)) != 0
+            || m_header->version != Version
+            || m_header->capacity == 0
+            || (m_header->capacity & (m_header->capacity - 1)) != 0
+            || m_mapping.size != sizeof(Header) + m_header->capacity * sizeof(uint64_t)) {
+            unmapFile(m_mapping);
+            throw std::invalid_argument(std::string("Invalid dedup store: ") + m_path);
+        }
+        m_slots = reinterpret_cast<std::atomic<uint64_t> *>(static_cast<char *>(m_mapping.data) + sizeof(Header));
+        m_count = reinterpret_cast<std::atomic<uint64_t> *>(&m_header->count);
+
+        // The count is only a cache, recount in case the last run crashed.
+        uint64_t count = 0;
+        for (uint64_t index = 0; index < m_header->capacity; index++) {
+            count += m_slots[index].load(std::memory_order_relaxed) != 0;
+        }
+        m_count->store(count);
+    }
+
+    void DedupStore::close() {
+        if (m_mapping.data != nullptr) {
+            flushMapping(m_mapping);
+            unmapFile(m_mapping);
+        }
+        m_header = nullptr;
+        m_slots = nullptr;
+        m_count = nullptr;
+    }
+
+    void DedupStore::grow(uint64_t capacity) {
+        std::string tempPath = m_path + ".tmp";
+        Mapping grown = mapFile(tempPath, sizeof(Header) + capacity * sizeof(uint64_t));
+        Header * header = static_cast<Header *>(grown.data);
+        auto slots = reinterpret_cast<std::atomic<uint64_t> *>(static_cast<char *>(grown.data) + sizeof(Header));
+        uint64_t count = 0;
+        for (uint64_t index = 0; index < m_header->capacity; index++) {
+            uint64_t fingerprint = m_slots[index].load(std::memory_order_relaxed);
+            if (fingerprint != 0) {
+                count += insertSlot(slots, capacity, fingerprint);
+            }
+        }
+        std::memcpy(header->magic, Magic, sizeof(Magic));
+        header->version = Version;
+        header->capacity = capacity;
+        header->count = count;
+        flushMapping(grown);
+        unmapFile(grown);
+
+#ifdef _WIN32
+        // A mapped file can not be replaced on Windows. The original stays
+        // complete until the rename succeeds, so it is mapped again if the
+        // rename fails.
+        close();
+        try {
+            replaceFile(tempPath, m_path);
+        }
+        catch (...) {
+            attach();
+            throw;
+        }
+#else
+        // The old table stays mapped if the rename fails.
+        replaceFile(tempPath, m_path);
+        close();
+#endif
+        attach();
+    }
+
+#ifdef _WIN32
+
+    DedupStore::Mapping DedupStore::mapFile(const std::string & filePath, size_t minSize) {
+        Mapping mapping;
+        mapping.file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapping.file == INVALID_HANDLE_VALUE) {
+            throw std::invalid_argument(std::string("Could not open file: ") + filePath);
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(mapping.file, &fileSize);
+        mapping.size = std::max(static_cast<size_t>(fileSize.QuadPart), minSize);
+        if (mapping.size == 0) {
+            CloseHandle(mapping.file);
+            throw std::invalid_argument(std::string("Invalid dedup store: ") + filePath);
+        }
+
+        // Mapping more than the file size extends the file with zeros.
+        uint64_t size = mapping.size;
+        mapping.map = CreateFileMappingA(mapping.file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (mapping.map != nullptr) {
+            mapping.data = MapViewOfFile(mapping.map, FILE_MAP_ALL_ACCESS, 0, 0, mapping.size);
+        }
+        if (mapping.data == nullptr) {
+            if (mapping.map != nullptr) {
+                CloseHandle(mapping.map);
+            }
+            CloseHandle(mapping.file);
+            throw std::runtime_error(std::string("Could not map file: ") + filePath);
+        }
+        return mapping;
+    }
+
+    void DedupStore::flushMapping(Mapping & mapping) {
+        FlushViewOfFile(mapping.data, 0);
+        FlushFileBuffers(mapping.file);
+    }
+
+    void DedupStore::unmapFile(Mapping & mapping) {
+        UnmapViewOfFile(mapping.data);
+        CloseHandle(mapping.map);
+        CloseHandle(mapping.file);
+        mapping = Mapping();
+    }
+
+    void DedupStore::lock() {
+        std::string lockPath = m_path + ".lock";
+        HANDLE file = CreateFileA(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::invalid_argument(std::string("Could not open file: ") + lockPath);
+        }
+        OVERLAPPED overlapped = {};
+        if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped)) {
+            CloseHandle(file);
+            throw std::runtime_error(std::string("Dedup store is in use by another process: ") + m_path);
+        }
+        m_lockFile = file;
+    }
+
+    void DedupStore::unlock() {
+        if (m_lockFile != nullptr) {
+            // Closing the handle releases the lock.
+            CloseHandle(m_lockFile);
+            m_lockFile = nullptr;
+        }
+    }
+
+#else
+
+    DedupStore::Mapping DedupStore::mapFile(const std::string & filePath, size_t minSize) {
+        Mapping mapping;
+        mapping.file = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (mapping.file < 0) {
+            throw std::invalid_argument(std::string("Could not open file: ") + filePath);
+        }
+        struct stat info;
+        fstat(mapping.file, &info);
+        mapping.size = std::max(static_cast<size_t>(info.st_size), minSize);
+        if (mapping.size == 0 || (static_cast<size_t>(info.st_size) < minSize && ftruncate(mapping.file, mapping.size) != 0)) {
+            ::close(mapping.file);
+            throw std::invalid_argument(std::string("Invalid dedup store: ") + filePath);
+        }
+
+        void * data = mmap(nullptr, mapping.size, PROT_READ | PROT_WRITE, MAP_SHARED, mapping.file, 0);
+        if (data == MAP_FAILED) {
+            ::close(mapping.file);
+            throw std::runtime_error(std::string("Could not map file: ") + filePath);
+        }
+        mapping.data = data;
+        return mapping;
+    }
+
+    void DedupStore::flushMapping(Mapping & mapping) {
+        msync(mapping.data, mapping.size, MS_SYNC);
+    }
+
+    void DedupStore::unmapFile(Mapping & mapping) {
+        munmap(mapping.data, mapping.size);
+        ::close(mapping.file);
+        mapping = Mapping();
+    }
+
+    void DedupStore::lock() {
+        std::string lockPath = m_path + ".lock";
+        int file = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (file < 0) {
+            throw std::invalid_argument(std::string("Could not open file: ") + lockPath);
+        }
+        if (flock(file, LOCK_EX | LOCK_NB) != 0) {
+            ::close(file);
+            throw std::runtime_error(std::string("Dedup store is in use by another process: ") + m_path);
+        }
+        m_lockFile = file;
+    }
+
+    void DedupStore::unlock() {
+        if (m_lockFile >= 0) {
+            // Closing the descriptor releases the lock.
+            ::close(m_lockFile);
+            m_lockFile = -1;
+        }
+    }
+
+#endif
+};
@@ -0,0 +1,117 @@
+/*
+Persistent store of puzzle fingerprints used to skip duplicate puzzles.
+
+A fingerprint is a 64 bit hash of the canonical form of a puzzle: the
+smallest grid reachable through the symmetries of the layout (transposing,
+swapping bands and stacks, swapping rows and columns within them and
+relabeling values), so transformed copies of a puzzle share a fingerprint.
+
+The DedupStore keeps the fingerprints in an open addressing hash table in a
+memory mapped file. Lookups and inserts take no locks; a slot goes from
+empty to its fingerprint with a single atomic compare and swap, so a crash
+never leaves a partly written entry. The table never moves while the store
+is in use. Opening the store grows it up front to fit the number of
+fingerprints the caller reserves, by building a new file next to the old
+one and renaming it over the original once it is complete.
+*/
+#ifndef DEDUP_STORE_H
+#define DEDUP_STORE_H
+
+#include "Layout.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Suduko {
+
+    // Writes the canonical form of a puzzle, both in compact form. Only value
+    // relabeling is applied for layouts other than the standard one since the
+    // other symmetries do not keep their units.
+    void canonicalForm(const uint8_t * puzzle, const Layout & layout, uint8_t * canonical);
+
+    // Hash of the canonical form. Never 0.
+    uint64_t fingerprint(const uint8_t * puzzle, const Layout & layout);
+
+    //========================================================================
+    // Class: DedupStore
+    //========================================================================
+
+    class DedupStore {
+    public:
+        static const uint64_t DefaultCapacity = 1 << 16;
+
+    private:
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t capacity;
+            uint64_t count;
+        };
+
+        // A memory mapped file and its platform handles.
+        struct Mapping {
+            void * data = nullptr;
+            size_t size = 0;
+#ifdef _WIN32
+            void * file = nullptr;
+            void * map = nullptr;
+#else
+            int file = -1;
+#endif
+        };
+
+        std::string m_path;
+        Mapping m_mapping;
+
+        // Advisory lock on <file>.lock, held while the store is open so a
+        // second process can not use the store or remove a grow in progress.
+#ifdef _WIN32
+        void * m_lockFile = nullptr;
+#else
+        int m_lockFile = -1;
+#endif
+        Header * m_header;
+        std::atomic<uint64_t> * m_slots;
+        std::atomic<uint64_t> * m_count;
+
+    public:
+        // Opens the store, creating it if it does not exist yet, and grows it
+        // so that reserve more fingerprints fit below the load limit. Throws
+        // std::runtime_error if another process has the store open.
+        DedupStore(const std::string & filePath, uint64_t reserve = DefaultCapacity);
+        ~DedupStore();
+
+        DedupStore(const DedupStore &) = delete;
+        DedupStore & operator=(const DedupStore &) = delete;
+
+        bool contains(uint64_t fingerprint);
+
+        // Adds a fingerprint. Returns false if it was already in the store.
+        // Going past the reserved room only lengthens probe sequences, a
+        // completely full table throws std::runtime_error.
+        bool insert(uint64_t fingerprint);
+
+        uint64_t size();
+        uint64_t capacity();
+
+        // Writes changes through to the file.
+        void flush();
+
+    private:
+        void open(uint64_t reserve);
+        void attach();
+        void close();
+        void grow(uint64_t capacity);
+        void lock();
+        void unlock();
+
+        static Mapping mapFile(const std::string & filePath, size_t minSize);
+        static void flushMapping(Mapping & mapping);
+        static void unmapFile(Mapping & mapping);
+    };
+};
+
+#endif
@@ -0,0 +1,320 @@
+#include "EditSession.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: EditSession
+    //========================================================================
+
+    EditSession::EditSession(const uint8_t * puzzle, std::shared_ptr<const Layout> layout) :
+        m_layout(layout),
+        m_values{},
+        m_givens{},
+        m_counts{},
+        m_unitMasks{},
+        m_positions{},
+        m_nakedQueued(0),
+        m_inNakedQueue{},
+        m_hiddenQueued(0),
+        m_inHiddenQueue{},
+        m_setCount(0),
+        m_conflicts(0)
+    {
+        // Starting from an empty board, where every value can go anywhere,
+        // each cell is refreshed once after all givens are in.
+        for (int cellId = 0; cellId < 81; cellId++) {
+            m_candidates[cellId] = 0x1FF;
+        }
+        for (int unitNo = 0; unitNo < m_layout->unitCount(); unitNo++) {
+            for (int value = 1; value <= 9; value++) {
+                m_positions[unitNo][value] = 9;
+            }
+        }
+
+        for (int cellId = 0; cellId < 81; cellId++) {
+            int value = puzzle[cellId];
+            if (value > 9) {
+                throw std::invalid_argument(std::string("Invalid value set: ") + std::to_string(value) + ".");
+            }
+            if (value != 0) {
+                addToUnits(cellId, value);
+                m_givens[cellId] = true;
+            }
+        }
+        for (int cellId = 0; cellId < 81; cellId++) {
+            refresh(cellId, 0x1FF);
+        }
+    }
+
+    bool EditSession::set(int cellId, int value) {
+        if (cellId < 0 || cellId > 80 || value < 0 || value > 9) {
+            throw std::invalid_argument(std::string("Invalid cell or value: ") + std::to_string(cellId) + ", " + std::to_string(value) + ".");
+        }
+        if (m_givens[cellId]) {
+            return false;
+        }
+        if (m_values[cellId] == value) {
+            return true;
+        }
+
+        m_undo.push_back(Move{ static_cast<uint8_t>(cellId), m_values[cellId] });
+        remove(cellId);
+        if (value != 0) {
+            place(cellId, value);
+        }
+        return true;
+    }
+
+    bool EditSession::unset(int cellId) {
+        return set(cellId, 0);
+    }
+
+    bool EditSession::undo() {
+        if (m_undo.empty()) {
+            return false;
+        }
+        auto move = m_undo.back();
+        m_undo.pop_back();
+        remove(move.cellId);
+        if (move.previous != 0) {
+            place(move.cellId, move.previous);
+        }
+        return true;
+    }
+
+    int EditSession::value(int cellId) {
+        return m_values[cellId];
+    }
+
+    bool EditSession::isGiven(int cellId) {
+        return m_givens[cellId];
+    }
+
+    uint16_t EditSession::candidates(int cellId) {
+        if (m_values[cellId] == 0) {
+            return m_candidates[cellId];
+        }
+        uint16_t used = 0;
+        const int * units = m_layout->cellUnits(cellId);
+        for (int i = 0, count = m_layout->cellUnitCount(cellId); i < count; i++) {
+            used |= m_unitMasks[units[i]];
+        }
+        return ~used & 0x1FF;
+    }
+
+    bool EditSession::isConflict(int cellId) {
+        int value = m_values[cellId];
+        if (value == 0) {
+            return false;
+        }
+        const int * units = m_layout->cellUnits(cellId);
+        for (int i = 0, count = m_layout->cellUnitCount(cellId); i < count; i++) {
+            if (m_counts[units[i]][value] > 1) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool EditSession::hasConflicts() {
+        return m_conflicts > 0;
+    }
+
+    bool EditSession::isSolved() {
+        return m_setCount == 81 && m_conflicts == 0;
+    }
+
+    std::optional<EditSession::Hint> EditSession::hint() {
+        if (m_conflicts > 0) {
+            return std::optional<Hint>();
+        }
+
+        // Naked singles: an unset cell with one candidate left.
+        while (m_nakedQueued > 0) {
+            int cellId = m_nakedQueue[m_nakedQueued - 1];
+            uint16_t mask = openMask(cellId);
+            if (mask != 0 && (mask & (mask - 1)) == 0) {
+                for (int value = 1; value <= 9; value++) {
+                    if (mask == (1 << (value - 1))) {
+                        return Hint{ cellId, value, NakedSingle, -1 };
+                    }
+                }
+            }
+            m_nakedQueued--;
+            m_inNakedQueue[cellId] = false;
+        }
+
+        // Hidden singles: a value with one place left in a unit.
+        while (m_hiddenQueued > 0) {
+            int unitNo = m_hiddenQueue[m_hiddenQueued - 1];
+            const int * unit = m_layout->unit(unitNo);
+            for (int value = 1; value <= 9; value++) {
+                if (m_positions[unitNo][value] != 1) {
+                    continue;
+                }
+                for (int i = 0; i < 9; i++) {
+                    if (openMask(unit[i]) & (1 << (value - 1))) {
+                        return Hint{ unit[i], value, HiddenSingle, unitNo };
+                    }
+                }
+            }
+            m_hiddenQueued--;
+            m_inHiddenQueue[unitNo] = false;
+        }
+        return std::optional<Hint>();
+    }
+
+    void EditSession::toCompact(uint8_t * values) {
+        for (int cellId = 0; cellId < 81; cellId++) {
+            values[cellId] = m_values[cellId];
+        }
+    }
+
+    void EditSession::place(int cellId, int value) {
+        uint16_t previousOpen = openMask(cellId);
+        bool masksChanged = addToUnits(cellId, value);
+        refreshAround(cellId, value, previousOpen, masksChanged);
+    }
+
+    void EditSession::remove(int cellId) {
+        int value = m_values[cellId];
+        if (value == 0) {
+            return;
+        }
+        bool masksChanged = removeFromUnits(cellId);
+        refreshAround(cellId, value, 0, masksChanged);
+    }
+
+    bool EditSession::addToUnits(int cellId, int value) {
+        bool masksChanged = false;
+        const int * units = m_layout->cellUnits(cellId);
+        for (int i = 0, count = m_layout->cellUnitCount(cellId); i < count; i++) {
+            uint8_t & used = m_counts[units[i]][value];
+            if (++used == 2) {
+                m_conflicts++;
+            }
+            if (used == 1) {
+                m_unitMasks[units[i]] |= 1 << (value - 1);
+                masksChanged = true;
+            }
+        }
+        m_values[cellId] = value;
+        m_setCount++;
+        return masksChanged;
+    }
+
+    bool EditSession::removeFromUnits(int cellId) {
+        int value = m_values[cellId];
+        bool masksChanged = false;
+        const int * units = m_layout->cellUnits(cellId);
+        for (int i = 0, count = m_layout->cellUnitCount(cellId); i < count; i++) {
+            uint8_t & used = m_counts[units[i]][value];
+            if (used-- == 2) {
+                m_conflicts--;
+            }
+            if (used == 0) {
+                m_unitMasks[units[i]] &= ~(1 << (value - 1));
+                masksChanged = true;
+            }
+        }
+        m_values[cellId] = 0;
+        m_setCount--;
+        return masksChanged;
+    }
+
+    uint16_t EditSession::openMask(int cellId) {
+        return (m_values[cellId] == 0) ? m_candidates[cellId] : 0;
+    }
+
+    void EditSession::refresh(int cellId, uint16_t previousOpen) {
+        const int * units = m_layout->cellUnits(cellId);
+        int unitCount = m_layout->cellUnitCount(cellId);
+        uint16_t open = 0;
+        if (m_values[cellId] == 0) {
+            uint16_t used = 0;
+            for (int i = 0; i < unitCount; i++) {
+                used |= m_unitMasks[units[i]];
+            }
+            open = ~used & 0x1FF;
+            m_candidates[cellId] = open;
+        }
+
+        uint16_t changed = open ^ previousOpen;
+        if (changed == 0) {
+            return;
+        }
+        queueIfNaked(cellId, open);
+
+        // A unit gets a hidden single when a value's places drop or grow to one.
+        for (int i = 0; i < unitCount; i++) {
+            int unitNo = units[i];
+            bool single = false;
+            uint16_t bits = changed;
+            for (int value = 1; bits != 0; value++, bits >>= 1) {
+                if (bits & 1) {
+                    uint8_t & places = m_positions[unitNo][value];
+                    places = (open & (1 << (value - 1))) ? places + 1 : places - 1;
+                    single = single || places == 1;
+                }
+            }
+            if (single) {
+                queueUnit(unitNo);
+            }
+        }
+    }
+
+    void EditSession::refreshValue(int cellId, int value) {
+        uint16_t bit = 1 << (value - 1);
+        const int * units = m_layout->cellUnits(cellId);
+        int unitCount = m_layout->cellUnitCount(cellId);
+        bool used = false;
+        for (int i = 0; i < unitCount; i++) {
+            used = used || (m_unitMasks[units[i]] & bit) != 0;
+        }
+        uint16_t previous = m_candidates[cellId];
+        uint16_t open = used ? (previous & ~bit) : (previous | bit);
+        if (open == previous) {
+            return;
+        }
+        m_candidates[cellId] = open;
+        queueIfNaked(cellId, open);
+
+        for (int i = 0; i < unitCount; i++) {
+            uint8_t & places = m_positions[units[i]][value];
+            places = used ? places - 1 : places + 1;
+            if (places == 1) {
+                queueUnit(units[i]);
+            }
+        }
+    }
+
+    void EditSession::refreshAround(int cellId, int value, uint16_t previousOpen, bool masksChanged) {
+        refresh(cellId, previousOpen);
+        if (!masksChanged) {
+            return;
+        }
+        const int * peers = m_layout->peers(cellId);
+        for (int i = 0, count = m_layout->peerCount(cellId); i < count; i++) {
+            if (m_values[peers[i]] == 0) {
+                refreshValue(peers[i], value);
+            }
+        }
+    }
+
+    void EditSession::queueIfNaked(int cellId, uint16_t open) {
+        if (open != 0 && (open & (open - 1)) == 0 && !m_inNakedQueue[cellId]) {
+            m_nakedQueue[m_nakedQueued++] = static_cast<uint8_t>(cellId);
+            m_inNakedQueue[cellId] = true;
+        }
+    }
+
+    void EditSession::queueUnit(int unitNo) {
+        if (!m_inHiddenQueue[unitNo]) {
+            m_hiddenQueue[m_hiddenQueued++] = static_cast<uint8_t>(unitNo);
+            m_inHiddenQueue[unitNo] = true;
+        }
+    }
+};
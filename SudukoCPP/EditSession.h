@@ -0,0 +1,145 @@
+/*
+Incremental editing of a puzzle for interactive clients.
+
+An EditSession holds the givens of a puzzle and the values a player has
+entered, including ones that repeat a value in a unit. Every unit keeps a
+count per value, so setting, clearing or undoing a value and checking a cell
+for conflicts only touches the units of that cell. The candidates of unset
+cells and the number of places left for each value in each unit are kept up
+to date for the peers of a changed cell, and cells or units that may have
+become a single are queued, so a hint only looks at those.
+*/
+#ifndef EDIT_SESSION_H
+#define EDIT_SESSION_H
+
+#include "Layout.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: EditSession
+    //========================================================================
+
+    class EditSession {
+    public:
+        enum HintKind { NakedSingle, HiddenSingle };
+
+        struct Hint {
+            int cellId;
+            int value;
+            HintKind kind;
+
+            // The unit the value is hidden in, -1 for a naked single.
+            int unitNo;
+        };
+
+    private:
+        struct Move {
+            uint8_t cellId;
+            uint8_t previous;
+        };
+
+        std::shared_ptr<const Layout> m_layout;
+        uint8_t m_values[81];
+        bool m_givens[81];
+
+        // Number of cells holding each value in each unit.
+        uint8_t m_counts[Layout::MaxUnits][10];
+
+        // Bit (value - 1) is set while the value is used in the unit.
+        uint16_t m_unitMasks[Layout::MaxUnits];
+
+        // Values not used in any unit of an unset cell, as a 9 bit mask.
+        uint16_t m_candidates[81];
+
+        // Number of unset cells in each unit that can still take each value.
+        uint8_t m_positions[Layout::MaxUnits][10];
+
+        // Cells that may be naked singles and units that may hold a hidden
+        // single. Every current single is queued; entries that no longer are
+        // one are dropped when hint() reaches them.
+        uint8_t m_nakedQueue[81];
+        int m_nakedQueued;
+        bool m_inNakedQueue[81];
+        uint8_t m_hiddenQueue[Layout::MaxUnits];
+        int m_hiddenQueued;
+        bool m_inHiddenQueue[Layout::MaxUnits];
+
+        // Number of set cells.
+        int m_setCount;
+
+        // Number of unit and value pairs used by more than one cell.
+        int m_conflicts;
+
+        std::vector<Move> m_undo;
+
+    public:
+        // Starts a session on a puzzle in compact form. Its set values are
+        // givens and can not be changed.
+        EditSession(const uint8_t * puzzle, std::shared_ptr<const Layout> layout = Layout::standard());
+
+        // Sets a value, 0 clears the cell. Returns false for givens.
+        bool set(int cellId, int value);
+
+        bool unset(int cellId);
+
+        // Reverts the last change made with set() or unset(). Returns false
+        // when there is nothing left to undo.
+        bool undo();
+
+        int value(int cellId);
+
+        bool isGiven(int cellId);
+
+        // Values not used in any unit of the cell, as a 9 bit mask.
+        uint16_t candidates(int cellId);
+
+        // Does the cell's value repeat in one of its units?
+        bool isConflict(int cellId);
+
+        bool hasConflicts();
+
+        // Is every cell set without conflicts?
+        bool isSolved();
+
+        // A single a player could fill in, naked ones first. Nothing while
+        // the board has conflicts or no single is left.
+        std::optional<Hint> hint();
+
+        void toCompact(uint8_t * values);
+
+    private:
+        void place(int cellId, int value);
+        void remove(int cellId);
+
+        // Update the unit counts and masks for a value entering or leaving
+        // a cell. Return true if a unit mask changed.
+        bool addToUnits(int cellId, int value);
+        bool removeFromUnits(int cellId);
+
+        // Candidates of an unset cell, none for a set one.
+        uint16_t openMask(int cellId);
+
+        // Recomputes the candidates of a cell after its value or any unit
+        // mask changed, given its open mask from before the change.
+        void refresh(int cellId, uint16_t previousOpen);
+
+        // Updates one candidate of an unset cell after a unit mask bit for
+        // the value changed.
+        void refreshValue(int cellId, int value);
+
+        // Refreshes a cell after a value was placed in or removed from it
+        // and, if one of its unit masks changed, the value for its peers.
+        void refreshAround(int cellId, int value, uint16_t previousOpen, bool masksChanged);
+
+        void queueIfNaked(int cellId, uint16_t open);
+        void queueUnit(int unitNo);
+    };
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "Enumerator.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Suduko {
+
+    namespace {
+
+        // Bit lookup tables shared by all enumerators.
+        struct Tables {
+            uint8_t bitCount[512];
+            uint8_t lowestValue[512];
+
+            Tables() {
+                for (int mask = 0; mask < 512; mask++) {
+                    bitCount[mask] = 0;
+                    lowestValue[mask] = 0;
+                    for (int value = 9; value >= 1; value--) {
+                        if (mask & (1 << (value - 1))) {
+                            bitCount[mask]++;
+                            lowestValue[mask] = value;
+                        }
+                    }
+                }
+            }
+        };
+
+        const Tables & tables() {
+            static const Tables instance;
+            return instance;
+        }
+    }
+
+    //========================================================================
+    // Class: Enumerator
+    //========================================================================
+
+    Enumerator::Enumerator(const uint8_t * puzzle, std::shared_ptr<const Layout> layout) :
+        m_layout(layout)
+    {
+        init(puzzle);
+    }
+
+    Enumerator::Enumerator(Board & board) :
+        m_layout(board.layout())
+    {
+        uint8_t puzzle[81];
+        board.toCompact(puzzle);
+        init(puzzle);
+
+        // Keep any eliminations already made on the board.
+        board.eachCell([this](Cell & cell) {
+            if (!cell.isSet()) {
+                uint16_t mask = 0;
+                for (auto value : cell.possibilities()) {
+                    mask |= 1 << (value - 1);
+                }
+                m_start.candidates[cell.id()] &= mask;
+            }
+        });
+    }
+
+    void Enumerator::init(const uint8_t * puzzle) {
+        m_valid = true;
+        m_start.unsolved = 81;
+        for (int cellId = 0; cellId < 81; cellId++) {
+            m_start.candidates[cellId] = 0x1FF;
+            m_start.values[cellId] = 0;
+        }
+        for (int cellId = 0; cellId < 81; cellId++) {
+            int value = puzzle[cellId];
+            if (value > 9) {
+                throw std::invalid_argument(std::string("Invalid value set: ") + std::to_string(value) + ".");
+            }
+            if (value != 0 && !assign(*m_layout, m_start, cellId, value)) {
+                m_valid = false;
+            }
+        }
+    }
+
+    bool Enumerator::valid() {
+        return m_valid;
+    }
+
+    uint64_t Enumerator::enumerate(const SolutionCallback & callback, uint64_t limit, int threads) {
+        return run(&callback, limit, threads, nullptr, 0);
+    }
+
+    uint64_t Enumerator::count(uint64_t limit, int threads) {
+        return run(nullptr, limit, threads, nullptr, 0);
+    }
+
+    size_t Enumerator::fill(uint8_t * buffer, size_t capacity) {
+        return run(nullptr, capacity, 1, buffer, capacity);
+    }
+
+    uint64_t Enumerator::solve(uint8_t * solution, uint64_t limit) {
+        return run(nullptr, limit, 1, solution, 1);
+    }
+
+    uint64_t Enumerator::run(const SolutionCallback * callback, uint64_t limit, int threads, uint8_t * buffer, size_t capacity) {
+        std::atomic<uint64_t> found(0);
+        std::atomic<bool> stop(false);
+        Search context{ m_layout.get(), callback, limit, &found, &stop, buffer, capacity };
+
+        if (!m_valid || limit == 0) {
+            return 0;
+        }
+        if (threads <= 1) {
+            State state = m_start;
+            search(state, context);
+            return found.load();
+        }
+
+        // Split the search tree on the first few branch cells so every
+        // thread gets a share of independent subtrees.
+        std::vector<State> frontier{ m_start };
+        while (frontier.size() < static_cast<size_t>(threads) * 16 && !stop.load()) {
+            std::vector<State> expanded;
+            for (auto & node : frontier) {
+                if (stop.load()) {
+                    break;
+                }
+                State state = node;
+                if (!propagate(*m_layout, state)) {
+                    continue;
+                }
+                if (state.unsolved == 0) {
+                    report(state, context);
+                    continue;
+                }
+                int cellId = chooseCell(state);
+                uint16_t candidates = state.candidates[cellId];
+                while (candidates != 0) {
+                    int value = tables().lowestValue[candidates];
+                    candidates &= ~(1 << (value - 1));
+                    State child = state;
+                    if (assign(*m_layout, child, cellId, value)) {
+                        expanded.push_back(child);
+                    }
+                }
+            }
+            frontier.swap(expanded);
+            if (frontier.empty()) {
+                break;
+            }
+        }
+
+        std::atomic<size_t> nextIndex(0);
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        try {
+            for (int i = 0; i < threads; i++) {
+                workers.emplace_back([&frontier, &nextIndex, &context, &stop]() {
+                    size_t index;
+                    while (!stop.load(std::memory_order_relaxed) && (index = nextIndex.fetch_add(1)) < frontier.size()) {
+                        State state = frontier[index];
+                        search(state, context);
+                    }
+                });
+            }
+        }
+        catch (...) {
+            // A thread could not be started. The ones already running are
+            // stopped and joined, destroying them joinable would terminate.
+            stop.store(true);
+            for (auto & worker : workers) {
+                worker.join();
+            }
+            throw;
+        }
+        for (auto & worker : workers) {
+            worker.join();
+        }
+        return found.load();
+    }
+
+    bool Enumerator::assign(const Layout & layout, State & state, int cellId, int value) {
+        uint16_t bit = 1 << (value - 1);
+        if ((state.candidates[cellId] & bit) == 0) {
+            return false;
+        }
+        state.values[cellId] = value;
+        state.candidates[cellId] = 0;
+        state.unsolved--;
+
+        const int * peers = layout.peers(cellId);
+        for (int i = 0, count = layout.peerCount(cellId); i < count; i++) {
+            int peer = peers[i];
+            if (state.values[peer] == 0 && (state.candidates[peer] & bit) != 0) {
+                state.candidates[peer] &= ~bit;
+                if (state.candidates[peer] == 0) {
+                    return false;
+                }
+            }
+            else if (state.values[peer] == value) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Enumerator::propagate(const Layout & layout, State & state) {
+        auto & t = tables();
+        bool changed = true;
+        while (changed && state.unsolved > 0) {
+            changed = false;
+
+            // Naked singles.
+            for (int cellId = 0; cellId < 81; cellId++) {
+                if (state.values[cellId] == 0 && t.bitCount[state.candidates[cellId]] <= 1) {
+                    if (state.candidates[cellId] == 0 || !assign(layout, state, cellId, t.lowestValue[state.candidates[cellId]])) {
+                        return false;
+                    }
+                    changed = true;
+                }
+            }
+
+            // Hidden singles.
+            for (int unitNo = 0; unitNo < layout.unitCount(); unitNo++) {
+                const int * unit = layout.unit(unitNo);
+                uint16_t once = 0;
+                uint16_t twice = 0;
+                uint16_t placed = 0;
+                for (int i = 0; i < 9; i++) {
+                    int cellId = unit[i];
+                    if (state.values[cellId] != 0) {
+                        placed |= 1 << (state.values[cellId] - 1);
+                    }
+                    else {
+                        twice |= once & state.candidates[cellId];
+                        once |= state.candidates[cellId];
+                    }
+                }
+                if ((once | placed) != 0x1FF) {
+                    return false;
+                }
+                uint16_t hidden = once & ~twice;
+                if (hidden == 0) {
+                    continue;
+                }
+                for (int i = 0; i < 9; i++) {
+                    int cellId = unit[i];
+                    uint16_t single = state.candidates[cellId] & hidden;
+                    if (state.values[cellId] == 0 && single != 0) {
+                        if (t.bitCount[single] > 1 || !assign(layout, state, cellId, t.lowestValue[single])) {
+                            return false;
+                        }
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    int Enumerator::chooseCell(State & state) {
+        auto & t = tables();
+        int best = -1;
+        int bestCount = 10;
+        for (int cellId = 0; cellId < 81; cellId++) {
+            if (state.values[cellId] == 0 && t.bitCount[state.candidates[cellId]] < bestCount) {
+                best = cellId;
+                bestCount = t.bitCount[state.candidates[cellId]];
+                if (bestCount <= 2) {
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    void Enumerator::search(State & state, Search & context) {
+        if (context.stop->load(std::memory_order_relaxed) || !propagate(*context.layout, state)) {
+            return;
+        }
+        if (state.unsolved == 0) {
+            report(state, context);
+            return;
+        }
+
+        int cellId = chooseCell(state);
+        uint16_t candidates = state.candidates[cellId];
+        while (candidates != 0) {
+            int value = tables().lowestValue[candidates];
+            candidates &= ~(1 << (value - 1));
+            State child = state;
+            if (assign(*context.layout, child, cellId, value)) {
+                search(child, context);
+            }
+            if (context.stop->load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    bool Enumerator::report(State & state, Search & context) {
+        // Once the callback or the limit stopped the search no further
+        // solutions are reported.
+        if (context.stop->load()) {
+            return false;
+        }
+        uint64_t number = context.found->fetch_add(1) + 1;
+        if (number > context.limit) {
+            context.found->fetch_sub(1);
+            context.stop->store(true);
+            return false;
+        }
+        if (context.buffer != nullptr && number <= context.capacity) {
+            std::memcpy(context.buffer + (number - 1) * 81, state.values, 81);
+        }
+        if (number == context.limit || (context.callback != nullptr && !(*context.callback)(state.values))) {
+            context.stop->store(true);
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,92 @@
+/*
+Allocation free enumeration and counting of Suduko solutions.
+
+Boards are handled in compact form: 81 bytes in row major order holding the
+values 1-9, with 0 for an unset cell. The search keeps candidates as 9 bit
+masks on the stack so no memory is allocated per node or per solution.
+*/
+#ifndef ENUMERATOR_H
+#define ENUMERATOR_H
+
+#include "Suduko.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+namespace Suduko {
+
+    // Receives a solution in compact form. Return false to stop the enumeration.
+    // When the enumeration runs on several threads the callback is called
+    // concurrently and must be thread safe. Returning false stops new calls,
+    // but each other thread may still make one more call that was already
+    // under way, so up to threads - 1 calls can follow the one that stopped
+    // the enumeration.
+    typedef std::function<bool(const uint8_t * solution)> SolutionCallback;
+
+    //========================================================================
+    // Class: Enumerator
+    //========================================================================
+
+    class Enumerator {
+    public:
+        static const uint64_t NoLimit = std::numeric_limits<uint64_t>::max();
+
+        // Search state for one node of the search tree.
+        struct State {
+            uint16_t candidates[81];
+            uint8_t values[81];
+            int unsolved;
+        };
+
+    private:
+        State m_start;
+        std::shared_ptr<const Layout> m_layout;
+        bool m_valid;
+
+    public:
+        Enumerator(const uint8_t * puzzle, std::shared_ptr<const Layout> layout = Layout::standard());
+        Enumerator(Board & board);
+
+        // Are the given values free of conflicts?
+        bool valid();
+
+        // Streams solutions to the callback. Returns the number of solutions
+        // produced, which stops at the limit or when the callback returns false.
+        uint64_t enumerate(const SolutionCallback & callback, uint64_t limit = NoLimit, int threads = 1);
+
+        // Counts solutions without producing them.
+        uint64_t count(uint64_t limit = NoLimit, int threads = 1);
+
+        // Writes up to capacity solutions into buffer, 81 bytes each.
+        // Returns the number of solutions written.
+        size_t fill(uint8_t * buffer, size_t capacity);
+
+        // Solves into solution. Returns the number of solutions seen up to
+        // the limit, so a limit of 2 also tells if the solution is unique.
+        uint64_t solve(uint8_t * solution, uint64_t limit = 1);
+
+    private:
+        struct Search {
+            const Layout * layout;
+            const SolutionCallback * callback;
+            uint64_t limit;
+            std::atomic<uint64_t> * found;
+            std::atomic<bool> * stop;
+            uint8_t * buffer;
+            size_t capacity;
+        };
+
+        void init(const uint8_t * puzzle);
+        uint64_t run(const SolutionCallback * callback, uint64_t limit, int threads, uint8_t * buffer, size_t capacity);
+        static bool assign(const Layout & layout, State & state, int cellId, int value);
+        static bool propagate(const Layout & layout, State & state);
+        static int chooseCell(State & state);
+        static void search(State & state, Search & context);
+        static bool report(State & state, Search & context);
+    };
+};
+
+#endif
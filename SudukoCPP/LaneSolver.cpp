@@ -0,0 +1,193 @@
+#include "LaneSolver.h"
+#include "Enumerator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace Suduko {
+
+    namespace {
+
+        int bitValue(uint16_t bit) {
+            for (int value = 1; value <= 9; value++) {
+                if (bit == (1 << (value - 1))) {
+                    return value;
+                }
+            }
+            return 0;
+        }
+    }
+
+    //========================================================================
+    // Class: LaneSolver
+    //========================================================================
+
+    LaneSolver::LaneSolver(std::shared_ptr<const Layout> layout) :
+        m_layout(layout),
+        m_branched(0)
+    {
+    }
+
+    void LaneSolver::solve(const uint8_t * puzzles, size_t count, uint8_t * solutions, bool * solved) {
+        for (size_t first = 0; first < count; first += Lanes) {
+            int lanes = static_cast<int>(std::min<size_t>(Lanes, count - first));
+            load(puzzles + first * 81, lanes);
+            propagate();
+
+            for (int lane = 0; lane < lanes; lane++) {
+                uint8_t * solution = solutions + (first + lane) * 81;
+                if (m_dead[lane] != 0) {
+                    solved[first + lane] = false;
+                    continue;
+                }
+                unload(lane, solution);
+                if (std::find(solution, solution + 81, 0) == solution + 81) {
+                    solved[first + lane] = true;
+                }
+                else {
+                    // Propagation stalled, branch on the partly solved board.
+                    Enumerator enumerator(solution, m_layout);
+                    solved[first + lane] = enumerator.solve(solution) == 1;
+                    m_branched++;
+                }
+            }
+        }
+    }
+
+    size_t LaneSolver::branched() {
+        return m_branched;
+    }
+
+    void LaneSolver::load(const uint8_t * puzzles, int count) {
+        for (int lane = 0; lane < Lanes; lane++) {
+            m_dead[lane] = (lane < count) ? 0 : 0xFFFF;
+        }
+        for (int cellId = 0; cellId < 81; cellId++) {
+            for (int lane = 0; lane < Lanes; lane++) {
+                uint16_t candidates = 0;
+                if (lane < count) {
+                    int value = puzzles[lane * 81 + cellId];
+                    if (value > 9) {
+                        throw std::invalid_argument(std::string("Invalid value set: ") + std::to_string(value) + ".");
+                    }
+                    // Givens start as single candidates and are placed by
+                    // the first naked single pass.
+                    candidates = (value == 0) ? 0x1FF : (1 << (value - 1));
+                }
+                m_candidates[cellId][lane] = candidates;
+                m_values[cellId][lane] = 0;
+            }
+        }
+    }
+
+    void LaneSolver::propagate() {
+        // The lane loops work on local copies so the compiler can tell they
+        // do not alias and vectorize them.
+        const Layout & layout = *m_layout;
+        alignas(32) uint16_t dead[Lanes];
+        alignas(32) uint16_t bits[Lanes];
+        std::memcpy(dead, m_dead, sizeof(dead));
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+
+            // Naked singles. An unset cell without candidates kills its lane.
+            for (int cellId = 0; cellId < 81; cellId++) {
+                alignas(32) uint16_t candidates[Lanes];
+                alignas(32) uint16_t values[Lanes];
+                std::memcpy(candidates, m_candidates[cellId], sizeof(candidates));
+                std::memcpy(values, m_values[cellId], sizeof(values));
+                uint16_t any = 0;
+                for (int lane = 0; lane < Lanes; lane++) {
+                    uint16_t c = candidates[lane];
+                    dead[lane] |= ((c | values[lane]) == 0) ? 0xFFFF : 0;
+                    bits[lane] = ((c & (c - 1)) == 0 ? c : 0) & ~dead[lane];
+                    any |= bits[lane];
+                }
+                if (any != 0) {
+                    place(cellId, bits);
+                    changed = true;
+                }
+            }
+
+            // Hidden singles.
+            for (int unitNo = 0; unitNo < layout.unitCount(); unitNo++) {
+                const int * unit = layout.unit(unitNo);
+                alignas(32) uint16_t once[Lanes] = {};
+                alignas(32) uint16_t twice[Lanes] = {};
+                alignas(32) uint16_t placed[Lanes] = {};
+                for (int i = 0; i < 9; i++) {
+                    alignas(32) uint16_t candidates[Lanes];
+                    alignas(32) uint16_t values[Lanes];
+                    std::memcpy(candidates, m_candidates[unit[i]], sizeof(candidates));
+                    std::memcpy(values, m_values[unit[i]], sizeof(values));
+                    for (int lane = 0; lane < Lanes; lane++) {
+                        twice[lane] |= once[lane] & candidates[lane];
+                        once[lane] |= candidates[lane];
+                        placed[lane] |= values[lane];
+                    }
+                }
+
+                uint16_t any = 0;
+                for (int lane = 0; lane < Lanes; lane++) {
+                    // A value with no place left in the unit kills the lane.
+                    dead[lane] |= ((once[lane] | placed[lane]) != 0x1FF) ? 0xFFFF : 0;
+                    once[lane] &= ~twice[lane] & ~dead[lane];
+                    any |= once[lane];
+                }
+                if (any == 0) {
+                    continue;
+                }
+
+                for (int i = 0; i < 9; i++) {
+                    alignas(32) uint16_t candidates[Lanes];
+                    std::memcpy(candidates, m_candidates[unit[i]], sizeof(candidates));
+                    uint16_t cellAny = 0;
+                    for (int lane = 0; lane < Lanes; lane++) {
+                        uint16_t hidden = candidates[lane] & once[lane];
+                        // A cell that is the only place for two values kills the lane.
+                        dead[lane] |= ((hidden & (hidden - 1)) != 0) ? 0xFFFF : 0;
+                        bits[lane] = hidden & ~dead[lane];
+                        cellAny |= bits[lane];
+                    }
+                    if (cellAny != 0) {
+                        place(unit[i], bits);
+                        changed = true;
+                    }
+                }
+            }
+        }
+        std::memcpy(m_dead, dead, sizeof(dead));
+    }
+
+    void LaneSolver::place(int cellId, const uint16_t * bits) {
+        alignas(32) uint16_t keep[Lanes];
+        for (int lane = 0; lane < Lanes; lane++) {
+            keep[lane] = ~bits[lane];
+        }
+
+        uint16_t * candidates = m_candidates[cellId];
+        uint16_t * values = m_values[cellId];
+        for (int lane = 0; lane < Lanes; lane++) {
+            values[lane] |= ~keep[lane];
+            candidates[lane] = (keep[lane] != 0xFFFF) ? 0 : candidates[lane];
+        }
+
+        const int * peers = m_layout->peers(cellId);
+        for (int i = 0, count = m_layout->peerCount(cellId); i < count; i++) {
+            uint16_t * peerCandidates = m_candidates[peers[i]];
+            for (int lane = 0; lane < Lanes; lane++) {
+                peerCandidates[lane] &= keep[lane];
+            }
+        }
+    }
+
+    void LaneSolver::unload(int lane, uint8_t * values) {
+        for (int cellId = 0; cellId < 81; cellId++) {
+            values[cellId] = bitValue(m_values[cellId][lane]);
+        }
+    }
+};
@@ -0,0 +1,65 @@
+/*
+Batch propagation of several Suduko puzzles in lockstep.
+
+A LaneSolver holds Lanes puzzles in structure of arrays form: the candidate
+masks for one cell of every puzzle are stored next to each other, so the
+naked and hidden single passes run the same operation over all lanes at
+once. The lane loops are plain fixed length loops over 16 bit masks that the
+compiler turns into SIMD code (16 lanes fill one 256 bit AVX2 register).
+
+Puzzles that propagation alone can not finish are handed to the scalar
+Enumerator to branch on.
+*/
+#ifndef LANE_SOLVER_H
+#define LANE_SOLVER_H
+
+#include "Layout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: LaneSolver
+    //========================================================================
+
+    class LaneSolver {
+    public:
+        static const int Lanes = 16;
+
+    private:
+        std::shared_ptr<const Layout> m_layout;
+
+        // Candidates of unset cells, 0 once a cell is set.
+        alignas(32) uint16_t m_candidates[81][Lanes];
+
+        // The bit of the value of set cells, 0 while a cell is unset.
+        alignas(32) uint16_t m_values[81][Lanes];
+
+        // 0xFFFF for lanes that hit a contradiction or hold no puzzle.
+        alignas(32) uint16_t m_dead[Lanes];
+
+        size_t m_branched;
+
+    public:
+        LaneSolver(std::shared_ptr<const Layout> layout = Layout::standard());
+
+        // Solves count puzzles in compact form, 81 bytes each, into solutions.
+        // solved[i] is set to whether puzzle i has a solution. Only the first
+        // solution is produced for puzzles with several.
+        void solve(const uint8_t * puzzles, size_t count, uint8_t * solutions, bool * solved);
+
+        // Number of puzzles that needed the scalar search so far.
+        size_t branched();
+
+    private:
+        void load(const uint8_t * puzzles, int count);
+        void propagate();
+        void place(int cellId, const uint16_t * bits);
+        void unload(int lane, uint8_t * values);
+    };
+};
+
+#endif
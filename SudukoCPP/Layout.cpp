@@ -0,0 +1,189 @@
+#include "Layout.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Layout
+    //========================================================================
+
+    Layout::Layout(const std::string & name, const std::vector<std::vector<int>> & units) :
+        m_name(name),
+        m_unitCount(0),
+        m_cellUnitCounts{},
+        m_peerCounts{}
+    {
+        if (units.size() > MaxUnits) {
+            throw std::invalid_argument(std::string("Too many units in layout: ") + name);
+        }
+
+        for (auto & unit : units) {
+            std::vector<int> sorted(unit);
+            std::sort(sorted.begin(), sorted.end());
+            if (sorted.size() != 9 || std::unique(sorted.begin(), sorted.end()) != sorted.end() || sorted[0] < 0 || sorted[8] > 80) {
+                throw std::invalid_argument(std::string("Invalid unit in layout: ") + name);
+            }
+
+            int unitNo = m_unitCount++;
+            for (int i = 0; i < 9; i++) {
+                int cellId = unit[i];
+                m_units[unitNo][i] = cellId;
+                if (m_cellUnitCounts[cellId] == MaxCellUnits) {
+                    throw std::invalid_argument(std::string("Too many units for a cell in layout: ") + name);
+                }
+                m_cellUnits[cellId][m_cellUnitCounts[cellId]++] = unitNo;
+            }
+        }
+
+        for (int cellId = 0; cellId < 81; cellId++) {
+            bool related[81] = {};
+            for (int i = 0; i < m_cellUnitCounts[cellId]; i++) {
+                for (auto other : m_units[m_cellUnits[cellId][i]]) {
+                    related[other] = other != cellId;
+                }
+            }
+            for (int other = 0; other < 81; other++) {
+                if (related[other]) {
+                    if (m_peerCounts[cellId] == MaxPeers) {
+                        throw std::invalid_argument(std::string("Too many peers for a cell in layout: ") + name);
+                    }
+                    m_peers[cellId][m_peerCounts[cellId]++] = other;
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<const Layout> Layout::standard() {
+        static const std::shared_ptr<const Layout> instance = create("standard");
+        return instance;
+    }
+
+    std::shared_ptr<const Layout> Layout::create(const std::string & variant, const std::vector<int> & regions) {
+        std::vector<std::vector<int>> units;
+
+        for (int rowNo = 0; rowNo < 9; rowNo++) {
+            std::vector<int> row;
+            for (int i = 0; i < 9; i++) {
+                row.push_back(rowNo * 9 + i);
+            }
+            units.push_back(row);
+        }
+        for (int colNo = 0; colNo < 9; colNo++) {
+            std::vector<int> col;
+            for (int i = 0; i < 9; i++) {
+                col.push_back(i * 9 + colNo);
+            }
+            units.push_back(col);
+        }
+
+        if (regions.empty()) {
+            for (int boxNo = 0; boxNo < 9; boxNo++) {
+                std::vector<int> box;
+                for (int i = 0; i < 9; i++) {
+                    box.push_back(((boxNo / 3) * 3 + i / 3) * 9 + (boxNo % 3) * 3 + i % 3);
+                }
+                units.push_back(box);
+            }
+        }
+        else {
+            if (regions.size() != 81) {
+                throw std::invalid_argument("Jigsaw regions must cover 81 cells.");
+            }
+            std::vector<std::vector<int>> regionUnits(9);
+            for (int cellId = 0; cellId < 81; cellId++) {
+                if (regions[cellId] < 0 || regions[cellId] > 8) {
+                    throw std::invalid_argument("Jigsaw region numbers must be 0-8.");
+                }
+                regionUnits[regions[cellId]].push_back(cellId);
+            }
+            units.insert(units.end(), regionUnits.begin(), regionUnits.end());
+        }
+
+        std::string name = regions.empty() ? "standard" : "jigsaw";
+        size_t pos = 0;
+        while (pos <= variant.size()) {
+            size_t end = variant.find('+', pos);
+            if (end == std::string::npos) {
+                end = variant.size();
+            }
+            std::string part = variant.substr(pos, end - pos);
+            pos = end + 1;
+
+            if (part.empty() || part == "standard" || part == "jigsaw") {
+                continue;
+            }
+            else if (part == "x") {
+                std::vector<int> diagonal;
+                std::vector<int> antiDiagonal;
+                for (int i = 0; i < 9; i++) {
+                    diagonal.push_back(i * 9 + i);
+                    antiDiagonal.push_back(i * 9 + (8 - i));
+                }
+                units.push_back(diagonal);
+                units.push_back(antiDiagonal);
+            }
+            else if (part == "windoku") {
+                for (int windowNo = 0; windowNo < 4; windowNo++) {
+                    int top = 1 + (windowNo / 2) * 4;
+                    int left = 1 + (windowNo % 2) * 4;
+                    std::vector<int> window;
+                    for (int i = 0; i < 9; i++) {
+                        window.push_back((top + i / 3) * 9 + left + i % 3);
+                    }
+                    units.push_back(window);
+                }
+            }
+            else {
+                throw std::invalid_argument(std::string("Unknown variant: ") + part);
+            }
+            name += "+" + part;
+        }
+
+        return std::make_shared<const Layout>(name, units);
+    }
+
+    std::vector<int> Layout::loadRegions(const std::string & filePath) {
+        std::ifstream input(filePath);
+        if (!input.is_open()) {
+            throw std::invalid_argument(std::string("Could not open file: ") + filePath);
+        }
+
+        std::map<char, int> regionNumbers;
+        std::vector<int> regions;
+        std::string line;
+        while (std::getline(input, line) && regions.size() < 81) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            if (line.length() < 9) {
+                throw std::invalid_argument(std::string("Invalid jigsaw region line in: ") + filePath);
+            }
+            for (int colNo = 0; colNo < 9; colNo++) {
+                auto iter = regionNumbers.find(line[colNo]);
+                if (iter == regionNumbers.end()) {
+                    int regionNo = regionNumbers.size();
+                    iter = regionNumbers.insert(std::make_pair(line[colNo], regionNo)).first;
+                }
+                regions.push_back(iter->second);
+            }
+        }
+        if (regions.size() != 81 || regionNumbers.size() != 9) {
+            throw std::invalid_argument(std::string("Jigsaw regions need 9 lines and 9 regions: ") + filePath);
+        }
+        return regions;
+    }
+
+    bool Layout::isStandard() const {
+        return m_name == "standard";
+    }
+};
@@ -0,0 +1,77 @@
+/*
+Constraint layouts for Suduko variants.
+
+A Layout is the precomputed table of units (groups of 9 cells that must hold
+each value once) for a board type, along with the units and peers of every
+cell. The standard layout has 27 units: rows 0-8, columns 9-17 and boxes
+18-26. Variants replace the boxes (jigsaw) or add units after them (the
+diagonals for X-Suduko, the four extra windows for windoku).
+*/
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Layout
+    //========================================================================
+
+    class Layout {
+    public:
+        static const int MaxUnits = 36;
+        static const int MaxCellUnits = 8;
+        static const int MaxPeers = 64;
+
+    private:
+        std::string m_name;
+        int m_unitCount;
+        int m_units[MaxUnits][9];
+        int m_cellUnitCounts[81];
+        int m_cellUnits[81][MaxCellUnits];
+        int m_peerCounts[81];
+        int m_peers[81][MaxPeers];
+
+    public:
+        // Builds the tables for a list of units, each given as 9 cell ids.
+        Layout(const std::string & name, const std::vector<std::vector<int>> & units);
+
+        // The standard 9x9 layout.
+        static std::shared_ptr<const Layout> standard();
+
+        // Builds a layout from the rows, columns and either the standard boxes
+        // or the jigsaw regions (region number 0-8 per cell) plus any extra
+        // units named in variant: "x" adds the diagonals and "windoku" the four
+        // extra windows. Names can be combined with '+', e.g. "x+windoku".
+        static std::shared_ptr<const Layout> create(const std::string & variant, const std::vector<int> & regions = std::vector<int>());
+
+        // Loads jigsaw regions from a file of 9 lines with 9 characters each.
+        // Characters that are the same belong to the same region.
+        static std::vector<int> loadRegions(const std::string & filePath);
+
+        const std::string & name() const { return m_name; }
+
+        int unitCount() const { return m_unitCount; }
+
+        // The 9 cell ids of a unit.
+        const int * unit(int unitNo) const { return m_units[unitNo]; }
+
+        int cellUnitCount(int cellId) const { return m_cellUnitCounts[cellId]; }
+
+        // The units a cell belongs to.
+        const int * cellUnits(int cellId) const { return m_cellUnits[cellId]; }
+
+        int peerCount(int cellId) const { return m_peerCounts[cellId]; }
+
+        // The cells sharing a unit with a cell, not including the cell.
+        const int * peers(int cellId) const { return m_peers[cellId]; }
+
+        // Does the layout have the standard rows, columns and boxes only?
+        bool isStandard() const;
+    };
+};
+
+#endif
@@ -1,53 +1,376 @@
 #include "Suduko.h"
+#include "DedupStore.h"
+#include "EditSession.h"
+#include "Enumerator.h"
+#include "LaneSolver.h"
+#include "Portfolio.h"
+#include "PuzzlePool.h"
+#include "ResultWriter.h"
+#include "SatSolver.h"
+#include "Tracer.h"
+#include "Verify.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 void help(const char * exeName) {
     // TODO: show help
 }
 
-void solve(std::string sudukoFile) {
-    auto board = Suduko::loadFromFile(sudukoFile);
-    Suduko::Solver solver(*board);
+Suduko::BoardFactory createSolver(Suduko::Board & board, const std::string & engine, long nodeBudget, bool adaptive, Suduko::Tracer * tracer) {
+    if (tracer != nullptr && engine != "rules") {
+        throw std::invalid_argument("Tracing is only supported by the rules engine.");
+    }
+    if (engine == "sat") {
+        auto solver = std::make_shared<Suduko::SatSolver>(board);
+        return [solver]() { return solver->next(); };
+    }
+    else if (engine == "auto") {
+        auto solver = std::make_shared<Suduko::FallbackSolver>(board, nodeBudget);
+        return [solver]() { return solver->next(); };
+    }
+    else if (engine == "rules") {
+        auto solver = std::make_shared<Suduko::Solver>(board);
+        solver->setTracer(tracer);
+        solver->setAdaptive(adaptive);
+        return [solver]() { return solver->next(); };
+    }
+    throw std::invalid_argument(std::string("Unknown engine: ") + engine);
+}
+
+std::string formatTime(const char * label, double ms) {
+    char text[64];
+    snprintf(text, sizeof(text), "%s %g ms.\n", label, ms);
+    return text;
+}
+
+// Races a portfolio of solver configurations and prints the first solution.
+void solvePortfolio(Suduko::Board & board, int instances, long nodeBudget) {
+    unsigned seed = static_cast<unsigned>(std::chrono::system_clock::now().time_since_epoch().count());
+    Suduko::Portfolio portfolio(board, instances, nodeBudget, seed);
+    Suduko::ResultWriter writer(stdout);
+    uint8_t values[81];
+
+    writer.write("Original board: \n");
+    board.toCompact(values);
+    writer.writeBoard(values, Suduko::ResultWriter::Grid);
+    writer.write("\n");
+
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    auto solved = portfolio.solve();
+    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time_span = t2 - t1;
+    std::string winner = portfolio.configs()[portfolio.winner()].name();
+    if (solved.has_value()) {
+        writer.write("Solved by " + winner + formatTime(" in", time_span.count()));
+        (*solved)->toCompact(values);
+        writer.writeBoard(values, Suduko::ResultWriter::Grid);
+        writer.write("\n");
+    }
+    else {
+        writer.write("No sollutions, proven by " + winner + formatTime(" in", time_span.count()));
+    }
+}
+
+void solve(std::string sudukoFile, std::shared_ptr<const Suduko::Layout> layout, const std::string & engine, long nodeBudget, bool adaptive, const std::string & traceFile, int portfolio) {
+    auto board = Suduko::loadFromFile(sudukoFile, layout);
+    if (portfolio > 1) {
+        if (!traceFile.empty()) {
+            throw std::invalid_argument("Tracing is not supported with a portfolio.");
+        }
+        solvePortfolio(*board, portfolio, nodeBudget);
+        return;
+    }
+    std::unique_ptr<Suduko::Tracer> tracer;
+    if (!traceFile.empty()) {
+        tracer.reset(new Suduko::Tracer());
+    }
+    auto nextSolution = createSolver(*board, engine, nodeBudget, adaptive, tracer.get());
+    Suduko::ResultWriter writer(stdout);
+    uint8_t values[81];
 
-    std::cout << "Original board: " << std::endl;
-    std::cout << board->display() << std::endl;
+    writer.write("Original board: \n");
+    board->toCompact(values);
+    writer.writeBoard(values, Suduko::ResultWriter::Grid);
+    writer.write("\n");
 
     while (true) {
         std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
-        auto solved = solver.next();
+        auto solved = nextSolution();
         std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> time_span = t2 - t1;
         if (solved.has_value()) {
-            std::cout << "Solved in " << time_span.count() << " ms." << std::endl;
-            std::cout << (*solved)->display() << std::endl;
+            writer.write(formatTime("Solved in", time_span.count()));
+            (*solved)->toCompact(values);
+            writer.writeBoard(values, Suduko::ResultWriter::Grid);
+            writer.write("\n");
         }
         else {
-            std::cout << "No further sollutions: " << time_span.count() << " ms." << std::endl;
+            writer.write(formatTime("No further sollutions:", time_span.count()));
             break;
         }
     }
+
+    if (tracer) {
+        FILE * file = fopen(traceFile.c_str(), "w");
+        if (file == nullptr) {
+            throw std::invalid_argument(std::string("Could not open file: ") + traceFile);
+        }
+        tracer->exportChromeTrace(file);
+        fclose(file);
+        writer.write("\n");
+        writer.write(tracer->summary());
+    }
+}
+
+// Each thread formats into its own writer, which only writes whole blocks.
+// Writers of worker threads flush when their thread exits.
+Suduko::ResultWriter & threadWriter() {
+    thread_local Suduko::ResultWriter writer(stdout);
+    return writer;
+}
+
+void solveAll(std::string sudukoFile, std::shared_ptr<const Suduko::Layout> layout, int threads, Suduko::ResultWriter::Format format) {
+    auto board = Suduko::loadFromFile(sudukoFile, layout);
+    Suduko::Enumerator enumerator(*board);
+
+    auto count = enumerator.enumerate([format](const uint8_t * solution) {
+        threadWriter().writeBoard(solution, format);
+        return true;
+    }, Suduko::Enumerator::NoLimit, threads);
+
+    threadWriter().flush();
+    std::cerr << "Solutions: " << count << "\n";
 }
 
-void generate(int setSize, int puzzleCount, int boardMaxTries) {
-    int count = 0;
-    while (count < puzzleCount) {
-        Suduko::Generator generator;
-        for (int i = 0; i < boardMaxTries; i++) {
-            auto boardOpt = generator.generate();
-            if (boardOpt.has_value()) {
-                auto board = *boardOpt;
-                if (board->cellSetCount() <= setSize) {
-                    std::cout << board->display() << std::endl;
-                    count++;
-                    break;
+void batch(std::string batchFile, std::shared_ptr<const Suduko::Layout> layout, int threads, Suduko::ResultWriter::Format format) {
+    const size_t chunkSize = 1024;
+    static const char noSolution[] = "No solution\n";
+
+    auto puzzles = Suduko::loadLinesFromFile(batchFile);
+    size_t puzzleCount = puzzles.size() / 81;
+    size_t chunkCount = (puzzleCount + chunkSize - 1) / chunkSize;
+    size_t boardSize = (format == Suduko::ResultWriter::Line) ? Suduko::ResultWriter::LineSize : Suduko::ResultWriter::GridSize;
+
+    // Chunks are solved and formatted in parallel and written in input order.
+    Suduko::OrderedWriter writer(stdout);
+    std::atomic<size_t> nextChunk(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::thread([&]() {
+            Suduko::LaneSolver laneSolver(layout);
+            std::vector<uint8_t> solutions(chunkSize * 81);
+            bool solved[chunkSize];
+            size_t chunk;
+            while ((chunk = nextChunk.fetch_add(1)) < chunkCount) {
+                size_t first = chunk * chunkSize;
+                size_t last = std::min(first + chunkSize, puzzleCount);
+                laneSolver.solve(puzzles.data() + first * 81, last - first, solutions.data(), solved);
+
+                std::vector<char> block((last - first) * std::max(boardSize + 1, sizeof(noSolution)));
+                char * pos = block.data();
+                for (size_t index = first; index < last; index++) {
+                    const uint8_t * solution = solutions.data() + (index - first) * 81;
+                    if (solved[index - first]) {
+                        pos += Suduko::ResultWriter::formatBoard(solution, format, pos);
+                        if (format == Suduko::ResultWriter::Grid) {
+                            *pos++ = '\n';
+                        }
+                    }
+                    else {
+                        std::memcpy(pos, noSolution, sizeof(noSolution) - 1);
+                        pos += sizeof(noSolution) - 1;
+                    }
                 }
+                block.resize(pos - block.data());
+                writer.submit(chunk, std::move(block));
             }
-        }
+        }));
+    }
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
+void countSolutions(std::string sudukoFile, std::shared_ptr<const Suduko::Layout> layout, int threads) {
+    auto board = Suduko::loadFromFile(sudukoFile, layout);
+    Suduko::Enumerator enumerator(*board);
+
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    auto count = enumerator.count(Suduko::Enumerator::NoLimit, threads);
+    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time_span = t2 - t1;
+    std::cout << "Solutions: " << count << " in " << time_span.count() << " ms." << std::endl;
+}
+
+bool verify(std::string verifyFile, std::shared_ptr<const Suduko::Layout> layout, int threads) {
+    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    auto report = Suduko::verifyFile(verifyFile, threads, 100, *layout);
+    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time_span = t2 - t1;
+
+    for (auto line : report.failedLines) {
+        std::cout << "Invalid solution on line " << line << "\n";
+    }
+    std::cout << "Verified " << report.checked << " solutions, " << report.failed << " invalid in " << time_span.count() << " ms." << std::endl;
+    return report.failed == 0;
+}
+
+void hint(std::string sudukoFile, std::shared_ptr<const Suduko::Layout> layout) {
+    auto board = Suduko::loadFromFile(sudukoFile, layout);
+    uint8_t values[81];
+    board->toCompact(values);
+    Suduko::EditSession session(values, layout);
+    auto next = session.hint();
+    if (!next.has_value()) {
+        std::cout << (session.hasConflicts() ? "No hint, the board has conflicts." : "No hint.") << std::endl;
+        return;
+    }
+    std::cout << "Set row " << (next->cellId / 9 + 1) << " column " << (next->cellId % 9 + 1) << " to " << next->value
+        << (next->kind == Suduko::EditSession::NakedSingle ? " (naked single)." : " (hidden single).") << std::endl;
+}
+
+void generate(std::shared_ptr<const Suduko::Layout> layout, int setSize, int puzzleCount, int boardMaxTries, int threads, const std::string & dedupFile) {
+    std::unique_ptr<Suduko::DedupStore> store;
+    if (!dedupFile.empty()) {
+        // Every puzzle written is one new fingerprint, so this reserves
+        // enough room that the store never grows while the workers run.
+        store.reset(new Suduko::DedupStore(dedupFile, std::max(puzzleCount, 1)));
+    }
+
+    std::atomic<int> count(0);
+    std::atomic<int> duplicates(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorLock;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::thread([&]() {
+            try {
+                uint8_t values[81];
+                while (count.load() < puzzleCount && !failed.load()) {
+                    Suduko::Generator generator(layout);
+                    for (int tries = 0; tries < boardMaxTries; tries++) {
+                        auto boardOpt = generator.generate();
+                        if (!boardOpt.has_value()) {
+                            break;
+                        }
+                        auto board = *boardOpt;
+                        if (board->cellSetCount() > setSize) {
+                            continue;
+                        }
+
+                        board->toCompact(values);
+                        uint64_t fingerprint = 0;
+                        if (store) {
+                            fingerprint = Suduko::fingerprint(values, *layout);
+                            if (store->contains(fingerprint)) {
+                                duplicates++;
+                                continue;
+                            }
+                        }
+
+                        // Reserve an output slot without ever going past the
+                        // requested count, so a slot given back below is
+                        // always picked up by another thread.
+                        int reserved = count.load();
+                        do {
+                            if (reserved >= puzzleCount) {
+                                return;
+                            }
+                        } while (!count.compare_exchange_weak(reserved, reserved + 1));
+
+                        if (store && !store->insert(fingerprint)) {
+                            // Another thread found the same puzzle first.
+                            count--;
+                            duplicates++;
+                            continue;
+                        }
+                        // Puzzles take a while to find, so each one is
+                        // written out as soon as it is ready.
+                        threadWriter().writeBoard(values, Suduko::ResultWriter::Grid);
+                        threadWriter().write("\n");
+                        threadWriter().flush();
+                        break;
+                    }
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorLock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }));
+    }
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    if (store) {
+        store->flush();
+        std::cerr << "Skipped " << duplicates.load() << " duplicates, " << store->size() << " puzzles in " << dedupFile << "\n";
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Emits transforms of verified pool puzzles instead of solving for new ones.
+// A spotCheckRate share of them is solved again to confirm they are unique.
+bool generateFromPool(const std::string & poolFile, std::shared_ptr<const Suduko::Layout> layout, int puzzleCount, int threads, double spotCheckRate, Suduko::ResultWriter::Format format) {
+    Suduko::PuzzlePool pool(poolFile, layout, threads);
+    unsigned seed = static_cast<unsigned>(std::chrono::system_clock::now().time_since_epoch().count());
+
+    std::atomic<int> checked(0);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::thread([&, i]() {
+            std::mt19937_64 random(seed + i);
+            std::bernoulli_distribution spotCheck(std::min(1.0, std::max(0.0, spotCheckRate)));
+            uint8_t values[81];
+            // 64 bit so count * threads can not overflow.
+            int64_t first = static_cast<int64_t>(puzzleCount) * i / threads;
+            int64_t last = static_cast<int64_t>(puzzleCount) * (i + 1) / threads;
+            for (int64_t n = first; n < last; n++) {
+                pool.sample(random, values);
+                if (spotCheck(random)) {
+                    checked++;
+                    Suduko::Enumerator enumerator(values, layout);
+                    if (enumerator.count(2) != 1) {
+                        failed++;
+                        continue;
+                    }
+                }
+                threadWriter().writeBoard(values, format);
+                if (format == Suduko::ResultWriter::Grid) {
+                    threadWriter().write("\n");
+                }
+            }
+        }));
+    }
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    if (spotCheckRate > 0) {
+        std::cerr << "Spot checked " << checked.load() << " puzzles, " << failed.load() << " without a unique solution.\n";
     }
+    return failed.load() == 0;
 }
 
 int main(int argc, char ** argv) {
@@ -57,6 +380,19 @@ int main(int argc, char ** argv) {
         int cellSet = 25;
         int boardMaxTries = 1000;
         std::string solveFile = "";
+        std::string engine = "rules";
+        long nodeBudget = 10000;
+        bool adaptive = true;
+        int portfolio = 0;
+        std::string poolFile = "";
+        double spotCheckRate = 0;
+        std::string traceFile = "";
+        std::string variant = "";
+        std::string jigsawFile = "";
+        std::string dedupFile = "";
+        Suduko::ResultWriter::Format format = Suduko::ResultWriter::Line;
+        int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        bool threadsGiven = false;
 
         for (int i = 1; i < argc; i ++) {
             if (strcmp(argv[i], "--generate") == 0) {
@@ -67,6 +403,31 @@ int main(int argc, char ** argv) {
                 solveFile = argv[i + 1];
                 i++;
             }
+            else if ((strcmp(argv[i], "--solveAll") == 0) && i < (argc - 1)) {
+                action = "solveAll";
+                solveFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--countSolutions") == 0) && i < (argc - 1)) {
+                action = "countSolutions";
+                solveFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--batch") == 0) && i < (argc - 1)) {
+                action = "batch";
+                solveFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--verify") == 0) && i < (argc - 1)) {
+                action = "verify";
+                solveFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--hint") == 0) && i < (argc - 1)) {
+                action = "hint";
+                solveFile = argv[i + 1];
+                i++;
+            }
             else if (strcmp(argv[i], "--help") == 0) {
                 action = "hep";
             }
@@ -78,20 +439,123 @@ int main(int argc, char ** argv) {
                 cellSet = atoi(argv[i + 1]);
                 i++;
             }
+            else if ((strcmp(argv[i], "--engine") == 0) && i < (argc - 1)) {
+                engine = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--trace") == 0) && i < (argc - 1)) {
+                traceFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--nodeBudget") == 0) && i < (argc - 1)) {
+                nodeBudget = atol(argv[i + 1]);
+                i++;
+            }
+            else if ((strcmp(argv[i], "--portfolio") == 0) && i < (argc - 1)) {
+                portfolio = atoi(argv[i + 1]);
+                i++;
+            }
+            else if ((strcmp(argv[i], "--schedule") == 0) && i < (argc - 1)) {
+                if (strcmp(argv[i + 1], "adaptive") == 0) {
+                    adaptive = true;
+                }
+                else if (strcmp(argv[i + 1], "fixed") == 0) {
+                    adaptive = false;
+                }
+                else {
+                    help(argv[0]);
+                    return 1;
+                }
+                i++;
+            }
+            else if ((strcmp(argv[i], "--variant") == 0) && i < (argc - 1)) {
+                variant = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--jigsaw") == 0) && i < (argc - 1)) {
+                jigsawFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--from-pool") == 0) && i < (argc - 1)) {
+                poolFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--spotCheck") == 0) && i < (argc - 1)) {
+                spotCheckRate = atof(argv[i + 1]);
+                i++;
+            }
+            else if ((strcmp(argv[i], "--dedup") == 0) && i < (argc - 1)) {
+                dedupFile = argv[i + 1];
+                i++;
+            }
+            else if ((strcmp(argv[i], "--format") == 0) && i < (argc - 1)) {
+                if (strcmp(argv[i + 1], "line") == 0) {
+                    format = Suduko::ResultWriter::Line;
+                }
+                else if (strcmp(argv[i + 1], "grid") == 0) {
+                    format = Suduko::ResultWriter::Grid;
+                }
+                else {
+                    help(argv[0]);
+                    return 1;
+                }
+                i++;
+            }
+            else if ((strcmp(argv[i], "--threads") == 0) && i < (argc - 1)) {
+                threads = std::max(1, atoi(argv[i + 1]));
+                threadsGiven = true;
+                i++;
+            }
             else {
                 help(argv[0]);
                 return 1;
             }
         }
 
+        auto layout = Suduko::Layout::standard();
+        if (!variant.empty() || !jigsawFile.empty()) {
+            std::vector<int> regions;
+            if (!jigsawFile.empty()) {
+                regions = Suduko::Layout::loadRegions(jigsawFile);
+            }
+            layout = Suduko::Layout::create(variant, regions);
+        }
+
         if (action == "help") {
             help(argv[0]);
         }
+        else if (action == "generate" && !poolFile.empty()) {
+            if (!dedupFile.empty()) {
+                // Transforms of a puzzle share its canonical form.
+                throw std::invalid_argument("--dedup can not be combined with --from-pool.");
+            }
+            if (!generateFromPool(poolFile, layout, count, threads, spotCheckRate, format)) {
+                return 1;
+            }
+        }
         else if (action == "generate") {
-            generate(cellSet, count, boardMaxTries);
+            // Generating has always run on one thread, more only on request.
+            generate(layout, cellSet, count, boardMaxTries, threadsGiven ? threads : 1, dedupFile);
         }
         else if (action == "solve") {
-            solve(solveFile);
+            solve(solveFile, layout, engine, nodeBudget, adaptive, traceFile, portfolio);
+        }
+        else if (action == "solveAll") {
+            solveAll(solveFile, layout, threads, format);
+        }
+        else if (action == "countSolutions") {
+            countSolutions(solveFile, layout, threads);
+        }
+        else if (action == "batch") {
+            batch(solveFile, layout, threads, format);
+        }
+        else if (action == "hint") {
+            hint(solveFile, layout);
+        }
+        else if (action == "verify") {
+            if (!verify(solveFile, layout, threads)) {
+                return 1;
+            }
         }
     }
     catch (const std::exception & e) {
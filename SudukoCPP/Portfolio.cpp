@@ -0,0 +1,124 @@
+#include "Portfolio.h"
+#include "SatSolver.h"
+
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Portfolio
+    //========================================================================
+
+    std::string Portfolio::Config::name() const {
+        std::string text = engine;
+        if (engine != "sat") {
+            text += adaptive ? " adaptive" : " fixed";
+            text += (branching == Solver::RandomFewest) ? " random-branch" : " first-branch";
+        }
+        return text + " seed " + std::to_string(seed);
+    }
+
+    Portfolio::Portfolio(Board & board, int instances, long nodeBudget, unsigned seed) :
+        m_board(board),
+        m_nodeBudget(nodeBudget),
+        m_configs(makeConfigs(instances, seed)),
+        m_winner(-1)
+    {}
+
+    std::optional<std::shared_ptr<Board>> Portfolio::solve() {
+        std::atomic<bool> stop(false);
+        std::optional<std::shared_ptr<Board>> result;
+        std::exception_ptr error;
+        std::mutex mutex;
+        m_winner = -1;
+
+        auto run = [&](int index, Board board) {
+            try {
+                const Config & config = m_configs[index];
+                std::optional<std::shared_ptr<Board>> solution;
+                if (config.engine == "sat") {
+                    SatSolver solver(board);
+                    solver.setSeed(config.seed);
+                    solver.setStopFlag(&stop);
+                    solution = solver.next();
+                }
+                else if (config.engine == "auto") {
+                    FallbackSolver solver(board, m_nodeBudget);
+                    solver.setAdaptive(config.adaptive);
+                    solver.setBranching(config.branching);
+                    solver.setSeed(config.seed);
+                    solver.setStopFlag(&stop);
+                    solution = solver.next();
+                }
+                else {
+                    Solver solver(board);
+                    solver.setAdaptive(config.adaptive);
+                    solver.setBranching(config.branching);
+                    solver.setSeed(config.seed);
+                    solver.setStopFlag(&stop);
+                    solution = solver.next();
+                }
+
+                // A solver that was stopped returns nothing as well, so only
+                // the first to finish may claim the result.
+                bool expected = false;
+                if (stop.compare_exchange_strong(expected, true)) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    result = solution;
+                    m_winner = index;
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        // Each thread gets its own copy of the board to start from.
+        std::vector<std::thread> workers;
+        for (int i = 0; i < static_cast<int>(m_configs.size()); i++) {
+            workers.push_back(std::thread(run, i, m_board));
+        }
+        for (auto & worker : workers) {
+            worker.join();
+        }
+
+        if (m_winner < 0 && error) {
+            std::rethrow_exception(error);
+        }
+        return result;
+    }
+
+    int Portfolio::winner() {
+        return m_winner;
+    }
+
+    const std::vector<Portfolio::Config> & Portfolio::configs() {
+        return m_configs;
+    }
+
+    std::vector<Portfolio::Config> Portfolio::makeConfigs(int instances, unsigned seed) {
+        if (instances < 1) {
+            throw std::invalid_argument("A portfolio needs at least one solver.");
+        }
+
+        static const Config base[] = {
+            { "rules", true, Solver::FirstFewest, 0 },
+            { "sat", true, Solver::FirstFewest, 0 },
+            { "rules", false, Solver::RandomFewest, 0 },
+            { "auto", true, Solver::RandomFewest, 0 }
+        };
+        std::vector<Config> configs;
+        for (int i = 0; i < instances; i++) {
+            Config config = (i < 4) ? base[i] : Config{ "rules", (i % 2) == 0, Solver::RandomFewest, 0 };
+            config.seed = seed + i;
+            configs.push_back(config);
+        }
+        return configs;
+    }
+};
@@ -0,0 +1,66 @@
+/*
+Portfolio solving of a single puzzle.
+
+Solve times of one configuration vary by orders of magnitude from puzzle to
+puzzle, and with random value ordering even from run to run. A Portfolio
+runs several differently configured or seeded solvers on their own threads.
+The first one to find a solution, or to prove there is none, wins and the
+others stop at their next search node or conflict.
+*/
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "Suduko.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Portfolio
+    //========================================================================
+
+    class Portfolio {
+    public:
+        struct Config {
+            // rules, sat or auto, as for --engine.
+            std::string engine;
+            bool adaptive;
+            Solver::Branching branching;
+            unsigned seed;
+
+            std::string name() const;
+        };
+
+    private:
+        Board m_board;
+        long m_nodeBudget;
+        std::vector<Config> m_configs;
+        int m_winner;
+
+    public:
+        // Sets up instances solver configurations, seeded from seed. The
+        // node budget is used by the auto engine before it falls back to SAT.
+        Portfolio(Board & board, int instances, long nodeBudget, unsigned seed);
+
+        // Runs all configurations until the first one finishes and returns
+        // its solution, or nothing when the puzzle has no solution.
+        std::optional<std::shared_ptr<Board>> solve();
+
+        // Index of the configuration that finished first, -1 before solve().
+        int winner();
+
+        const std::vector<Config> & configs();
+
+        // The configurations used for a portfolio of the given size. The
+        // first few cover each engine and heuristic, the rest are
+        // differently seeded rule engines.
+        static std::vector<Config> makeConfigs(int instances, unsigned seed);
+    };
+};
+
+#endif
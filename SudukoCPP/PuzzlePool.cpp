@@ -0,0 +1,98 @@
+#include "PuzzlePool.h"
+#include "Enumerator.h"
+#include "Suduko.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace Suduko {
+
+    namespace {
+
+        // A random permutation of 0-8 that keeps groups of three together.
+        void shuffleBands(std::mt19937_64 & random, int * order) {
+            int bands[3] = { 0, 1, 2 };
+            std::shuffle(bands, bands + 3, random);
+            for (int band = 0; band < 3; band++) {
+                int rows[3] = { 0, 1, 2 };
+                std::shuffle(rows, rows + 3, random);
+                for (int i = 0; i < 3; i++) {
+                    order[band * 3 + i] = bands[band] * 3 + rows[i];
+                }
+            }
+        }
+    }
+
+    void randomTransform(const uint8_t * puzzle, const Layout & layout, std::mt19937_64 & random, uint8_t * transformed) {
+        uint8_t values[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        std::shuffle(values + 1, values + 10, random);
+
+        if (!layout.isStandard()) {
+            for (int cellId = 0; cellId < 81; cellId++) {
+                transformed[cellId] = values[puzzle[cellId]];
+            }
+            return;
+        }
+
+        int rows[9];
+        int cols[9];
+        shuffleBands(random, rows);
+        shuffleBands(random, cols);
+        bool transpose = (random() & 1) != 0;
+        for (int rowNo = 0; rowNo < 9; rowNo++) {
+            for (int colNo = 0; colNo < 9; colNo++) {
+                int from = transpose ? cols[colNo] * 9 + rows[rowNo] : rows[rowNo] * 9 + cols[colNo];
+                transformed[rowNo * 9 + colNo] = values[puzzle[from]];
+            }
+        }
+    }
+
+    //========================================================================
+    // Class: PuzzlePool
+    //========================================================================
+
+    PuzzlePool::PuzzlePool(const std::string & filePath, std::shared_ptr<const Layout> layout, int threads) :
+        m_layout(layout)
+    {
+        m_puzzles = loadLinesFromFile(filePath, &m_lineNumbers);
+        size_t count = m_puzzles.size() / 81;
+        if (count == 0) {
+            throw std::invalid_argument(std::string("No puzzles in pool: ") + filePath);
+        }
+
+        // Transforms only keep uniqueness, so every puzzle of the pool has
+        // to have it to begin with.
+        std::atomic<size_t> nextIndex(0);
+        std::atomic<size_t> firstInvalid(count);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < std::max(1, threads); i++) {
+            workers.push_back(std::thread([this, count, &nextIndex, &firstInvalid]() {
+                for (size_t index = nextIndex++; index < count; index = nextIndex++) {
+                    Enumerator enumerator(&m_puzzles[index * 81], m_layout);
+                    if (!enumerator.valid() || enumerator.count(2) != 1) {
+                        size_t current = firstInvalid.load();
+                        while (index < current && !firstInvalid.compare_exchange_weak(current, index)) {
+                        }
+                    }
+                }
+            }));
+        }
+        for (auto & worker : workers) {
+            worker.join();
+        }
+        if (firstInvalid.load() < count) {
+            throw std::invalid_argument(std::string("Puzzle on line ") + std::to_string(m_lineNumbers[firstInvalid.load()]) + " of " + filePath + " does not have a unique solution.");
+        }
+    }
+
+    size_t PuzzlePool::size() {
+        return m_puzzles.size() / 81;
+    }
+
+    void PuzzlePool::sample(std::mt19937_64 & random, uint8_t * puzzle) {
+        size_t index = std::uniform_int_distribution<size_t>(0, size() - 1)(random);
+        randomTransform(&m_puzzles[index * 81], *m_layout, random, puzzle);
+    }
+};
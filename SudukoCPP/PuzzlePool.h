@@ -0,0 +1,50 @@
+/*
+New puzzles from a pool of verified ones through symmetry transforms.
+
+Any symmetry of the layout maps a puzzle with a unique solution to another
+puzzle with a unique solution and the same difficulty. For the standard
+layout those are transposing, swapping bands and stacks, swapping rows and
+columns within them and relabeling values. Only relabeling is used for other
+layouts since the other symmetries do not keep their units.
+*/
+#ifndef PUZZLE_POOL_H
+#define PUZZLE_POOL_H
+
+#include "Layout.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    // Writes a random symmetry transform of a puzzle, both in compact form.
+    void randomTransform(const uint8_t * puzzle, const Layout & layout, std::mt19937_64 & random, uint8_t * transformed);
+
+    //========================================================================
+    // Class: PuzzlePool
+    //========================================================================
+
+    class PuzzlePool {
+    private:
+        std::shared_ptr<const Layout> m_layout;
+        std::vector<uint8_t> m_puzzles;
+
+        // Line in the pool file of each puzzle, for error messages.
+        std::vector<size_t> m_lineNumbers;
+
+    public:
+        // Loads puzzles stored one per line, see loadLinesFromFile(), and
+        // checks that each has a unique solution.
+        PuzzlePool(const std::string & filePath, std::shared_ptr<const Layout> layout = Layout::standard(), int threads = 1);
+
+        size_t size();
+
+        // Writes a random transform of a random puzzle of the pool.
+        void sample(std::mt19937_64 & random, uint8_t * puzzle);
+    };
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "ResultWriter.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: ResultWriter
+    //========================================================================
+
+    ResultWriter::ResultWriter(FILE * file, size_t capacity) :
+        m_file(file),
+        m_buffer(capacity < GridSize ? GridSize : capacity),
+        m_used(0)
+    {}
+
+    ResultWriter::~ResultWriter() {
+        flush();
+    }
+
+    void ResultWriter::writeBoard(const uint8_t * values, Format format) {
+        char * out = reserve(format == Line ? LineSize : GridSize);
+        m_used += formatBoard(values, format, out);
+    }
+
+    void ResultWriter::write(const char * text, size_t length) {
+        if (length > m_buffer.size()) {
+            flush();
+            fwrite(text, 1, length, m_file);
+            return;
+        }
+        std::memcpy(reserve(length), text, length);
+        m_used += length;
+    }
+
+    void ResultWriter::write(const std::string & text) {
+        write(text.data(), text.size());
+    }
+
+    void ResultWriter::flush() {
+        if (m_used > 0) {
+            fwrite(m_buffer.data(), 1, m_used, m_file);
+            m_used = 0;
+        }
+        fflush(m_file);
+    }
+
+    char * ResultWriter::reserve(size_t length) {
+        if (m_used + length > m_buffer.size()) {
+            fwrite(m_buffer.data(), 1, m_used, m_file);
+            m_used = 0;
+        }
+        return m_buffer.data() + m_used;
+    }
+
+    size_t ResultWriter::formatBoard(const uint8_t * values, Format format, char * out) {
+        return (format == Line) ? formatLine(values, out) : formatGrid(values, out);
+    }
+
+    size_t ResultWriter::formatLine(const uint8_t * values, char * out) {
+        for (int cellId = 0; cellId < 81; cellId++) {
+            out[cellId] = values[cellId] == 0 ? '.' : '0' + values[cellId];
+        }
+        out[81] = '\n';
+        return LineSize;
+    }
+
+    size_t ResultWriter::formatGrid(const uint8_t * values, char * out) {
+        static const char separator[] = "---+---+---\n";
+
+        char * pos = out;
+        for (int rowNo = 0; rowNo < 9; rowNo++) {
+            if (rowNo == 3 || rowNo == 6) {
+                std::memcpy(pos, separator, 12);
+                pos += 12;
+            }
+            for (int colNo = 0; colNo < 9; colNo++) {
+                if (colNo == 3 || colNo == 6) {
+                    *pos++ = '|';
+                }
+                int value = values[rowNo * 9 + colNo];
+                *pos++ = value == 0 ? ' ' : '0' + value;
+            }
+            *pos++ = '\n';
+        }
+        return pos - out;
+    }
+
+    //========================================================================
+    // Class: OrderedWriter
+    //========================================================================
+
+    OrderedWriter::OrderedWriter(FILE * file) :
+        m_file(file),
+        m_next(0),
+        m_writing(false)
+    {}
+
+    void OrderedWriter::submit(uint64_t sequence, std::vector<char> block) {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_pending.emplace(sequence, std::move(block));
+
+        // Only one thread drains at a time, the others just leave their block.
+        if (m_writing) {
+            return;
+        }
+        m_writing = true;
+
+        while (!m_pending.empty() && m_pending.begin()->first == m_next) {
+            std::vector<std::vector<char>> ready;
+            while (!m_pending.empty() && m_pending.begin()->first == m_next) {
+                ready.push_back(std::move(m_pending.begin()->second));
+                m_pending.erase(m_pending.begin());
+                m_next++;
+            }
+
+            guard.unlock();
+            for (auto & readyBlock : ready) {
+                fwrite(readyBlock.data(), 1, readyBlock.size(), m_file);
+            }
+            guard.lock();
+        }
+
+        m_writing = false;
+        if (m_pending.empty()) {
+            fflush(m_file);
+        }
+    }
+};
@@ -0,0 +1,89 @@
+/*
+Buffered output of Suduko boards.
+
+Boards are formatted straight into preallocated buffers, either as a single
+line of 81 digits or as the grid used by Board::display(), and written out in
+large blocks.
+*/
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: ResultWriter
+    //========================================================================
+
+    class ResultWriter {
+    public:
+        enum Format { Line, Grid };
+
+        // Bytes used by one board in each format.
+        static const size_t LineSize = 82;
+        static const size_t GridSize = 132;
+
+    private:
+        FILE * m_file;
+        std::vector<char> m_buffer;
+        size_t m_used;
+
+    public:
+        ResultWriter(FILE * file, size_t capacity = 1 << 20);
+        ~ResultWriter();
+
+        ResultWriter(const ResultWriter &) = delete;
+        ResultWriter & operator=(const ResultWriter &) = delete;
+
+        // Writes a board given in compact form.
+        void writeBoard(const uint8_t * values, Format format);
+
+        void write(const char * text, size_t length);
+
+        void write(const std::string & text);
+
+        void flush();
+
+        // Formats a board into out, which must hold LineSize or GridSize
+        // bytes. Returns the number of bytes written.
+        static size_t formatBoard(const uint8_t * values, Format format, char * out);
+
+        static size_t formatLine(const uint8_t * values, char * out);
+
+        static size_t formatGrid(const uint8_t * values, char * out);
+
+    private:
+        char * reserve(size_t length);
+    };
+
+    //========================================================================
+    // Class: OrderedWriter
+    //========================================================================
+
+    // Collects blocks of output formatted on several threads and writes
+    // them in sequence order. Blocks are written outside of the lock so
+    // formatting threads never wait on the output itself.
+    class OrderedWriter {
+    private:
+        FILE * m_file;
+        std::mutex m_lock;
+        std::map<uint64_t, std::vector<char>> m_pending;
+        uint64_t m_next;
+        bool m_writing;
+
+    public:
+        OrderedWriter(FILE * file);
+
+        // Hands over the block with the given sequence number. Sequence
+        // numbers start at 0 and every number must be submitted once.
+        void submit(uint64_t sequence, std::vector<char> block);
+    };
+};
+
+#endif
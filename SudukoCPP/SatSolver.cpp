@@ -0,0 +1,500 @@
+#include "SatSolver.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Cdcl
+    //========================================================================
+
+    Cdcl::Cdcl(int varCount) :
+        m_varCount(varCount),
+        m_watches(varCount * 2),
+        m_values(varCount, -1),
+        m_levels(varCount, 0),
+        m_reasons(varCount, -1),
+        m_phases(varCount, 0),
+        m_activity(varCount, 0.0),
+        m_seen(varCount, 0),
+        m_propagateHead(0),
+        m_activityIncrement(1.0),
+        m_unsat(false),
+        m_conflicts(0),
+        m_stopFlag(nullptr)
+    {}
+
+    bool Cdcl::addClause(std::vector<int> lits) {
+        if (m_unsat) {
+            return false;
+        }
+
+        std::sort(lits.begin(), lits.end());
+        lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+
+        // Drop literals that are false at level 0 and skip satisfied clauses.
+        size_t kept = 0;
+        for (size_t i = 0; i < lits.size(); i++) {
+            int value = litValue(lits[i]);
+            if (value == 1 || (i > 0 && lits[i] == (lits[i - 1] ^ 1))) {
+                return true;
+            }
+            if (value == -1) {
+                lits[kept++] = lits[i];
+            }
+        }
+        lits.resize(kept);
+
+        if (lits.empty()) {
+            m_unsat = true;
+            return false;
+        }
+        if (lits.size() == 1) {
+            enqueue(lits[0], -1);
+            if (propagate() >= 0) {
+                m_unsat = true;
+                return false;
+            }
+            return true;
+        }
+
+        m_clauses.push_back(std::move(lits));
+        attach(m_clauses.size() - 1);
+        return true;
+    }
+
+    Cdcl::Result Cdcl::solve() {
+        if (m_unsat) {
+            return Unsat;
+        }
+
+        std::vector<int> learnt;
+        for (long restart = 0; ; restart++) {
+            long restartConflicts = luby(restart) * 64;
+            long conflictCount = 0;
+
+            while (true) {
+                int conflict = propagate();
+                if (conflict >= 0) {
+                    if (m_stopFlag != nullptr && m_stopFlag->load(std::memory_order_relaxed)) {
+                        backtrack(0);
+                        return Unknown;
+                    }
+                    m_conflicts++;
+                    conflictCount++;
+                    if (decisionLevel() == 0) {
+                        m_unsat = true;
+                        return Unsat;
+                    }
+
+                    int backtrackLevel = 0;
+                    analyze(conflict, learnt, backtrackLevel);
+                    backtrack(backtrackLevel);
+                    if (learnt.size() == 1) {
+                        enqueue(learnt[0], -1);
+                    }
+                    else {
+                        m_clauses.push_back(learnt);
+                        attach(m_clauses.size() - 1);
+                        enqueue(learnt[0], m_clauses.size() - 1);
+                    }
+                    m_activityIncrement /= 0.95;
+                }
+                else {
+                    if (conflictCount >= restartConflicts) {
+                        backtrack(0);
+                        break;
+                    }
+                    int var = pickBranchVariable();
+                    if (var < 0) {
+                        return Sat;
+                    }
+                    m_trailLimits.push_back(m_trail.size());
+                    enqueue(lit(var, m_phases[var] != 1), -1);
+                }
+            }
+        }
+    }
+
+    bool Cdcl::modelValue(int var) {
+        return m_values[var] == 1;
+    }
+
+    void Cdcl::reset() {
+        backtrack(0);
+    }
+
+    long Cdcl::conflicts() {
+        return m_conflicts;
+    }
+
+    int Cdcl::litValue(int lit) {
+        int value = m_values[lit >> 1];
+        if (value < 0) {
+            return -1;
+        }
+        return (lit & 1) ? 1 - value : value;
+    }
+
+    int Cdcl::decisionLevel() {
+        return m_trailLimits.size();
+    }
+
+    void Cdcl::enqueue(int lit, int reason) {
+        int var = lit >> 1;
+        m_values[var] = (lit & 1) ? 0 : 1;
+        m_levels[var] = decisionLevel();
+        m_reasons[var] = reason;
+        m_trail.push_back(lit);
+    }
+
+    int Cdcl::propagate() {
+        while (m_propagateHead < m_trail.size()) {
+            int falseLit = m_trail[m_propagateHead++] ^ 1;
+            auto & watches = m_watches[falseLit];
+
+            size_t i = 0;
+            size_t j = 0;
+            while (i < watches.size()) {
+                int clauseIndex = watches[i++];
+                auto & clause = m_clauses[clauseIndex];
+                if (clause[0] == falseLit) {
+                    std::swap(clause[0], clause[1]);
+                }
+                if (litValue(clause[0]) == 1) {
+                    watches[j++] = clauseIndex;
+                    continue;
+                }
+
+                // Look for a new literal to watch.
+                bool moved = false;
+                for (size_t k = 2; k < clause.size(); k++) {
+                    if (litValue(clause[k]) != 0) {
+                        std::swap(clause[1], clause[k]);
+                        m_watches[clause[1]].push_back(clauseIndex);
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) {
+                    continue;
+                }
+
+                watches[j++] = clauseIndex;
+                if (litValue(clause[0]) == 0) {
+                    while (i < watches.size()) {
+                        watches[j++] = watches[i++];
+                    }
+                    watches.resize(j);
+                    return clauseIndex;
+                }
+                enqueue(clause[0], clauseIndex);
+            }
+            watches.resize(j);
+        }
+        return -1;
+    }
+
+    void Cdcl::analyze(int conflict, std::vector<int> & learnt, int & backtrackLevel) {
+        learnt.clear();
+        learnt.push_back(-1);
+
+        int pathCount = 0;
+        int p = -1;
+        int index = m_trail.size() - 1;
+        int clauseIndex = conflict;
+
+        // Walk back along the trail until only the first unique implication
+        // point of the current level remains.
+        do {
+            auto & clause = m_clauses[clauseIndex];
+            for (size_t k = (p == -1) ? 0 : 1; k < clause.size(); k++) {
+                int q = clause[k];
+                int var = q >> 1;
+                if (!m_seen[var] && m_levels[var] > 0) {
+                    m_seen[var] = 1;
+                    bumpActivity(var);
+                    if (m_levels[var] >= decisionLevel()) {
+                        pathCount++;
+                    }
+                    else {
+                        learnt.push_back(q);
+                    }
+                }
+            }
+            while (!m_seen[m_trail[index] >> 1]) {
+                index--;
+            }
+            p = m_trail[index--];
+            clauseIndex = m_reasons[p >> 1];
+            m_seen[p >> 1] = 0;
+            pathCount--;
+        } while (pathCount > 0);
+        learnt[0] = p ^ 1;
+
+        backtrackLevel = 0;
+        if (learnt.size() > 1) {
+            size_t maxIndex = 1;
+            for (size_t k = 2; k < learnt.size(); k++) {
+                if (m_levels[learnt[k] >> 1] > m_levels[learnt[maxIndex] >> 1]) {
+                    maxIndex = k;
+                }
+            }
+            std::swap(learnt[1], learnt[maxIndex]);
+            backtrackLevel = m_levels[learnt[1] >> 1];
+        }
+        for (auto q : learnt) {
+            m_seen[q >> 1] = 0;
+        }
+    }
+
+    void Cdcl::backtrack(int level) {
+        if (decisionLevel() <= level) {
+            return;
+        }
+        for (int i = m_trail.size() - 1; i >= m_trailLimits[level]; i--) {
+            int var = m_trail[i] >> 1;
+            m_phases[var] = m_values[var];
+            m_values[var] = -1;
+            m_reasons[var] = -1;
+        }
+        m_trail.resize(m_trailLimits[level]);
+        m_trailLimits.resize(level);
+        m_propagateHead = m_trail.size();
+    }
+
+    void Cdcl::bumpActivity(int var) {
+        m_activity[var] += m_activityIncrement;
+        if (m_activity[var] > 1e100) {
+            for (auto & activity : m_activity) {
+                activity *= 1e-100;
+            }
+            m_activityIncrement *= 1e-100;
+        }
+    }
+
+    void Cdcl::randomize(unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> jitter(0.0, 1e-3);
+        for (int var = 0; var < m_varCount; var++) {
+            m_activity[var] += jitter(random);
+            m_phases[var] = random() & 1;
+        }
+    }
+
+    void Cdcl::setStopFlag(const std::atomic<bool> * stopFlag) {
+        m_stopFlag = stopFlag;
+    }
+
+    int Cdcl::pickBranchVariable() {
+        int best = -1;
+        for (int var = 0; var < m_varCount; var++) {
+            if (m_values[var] < 0 && (best < 0 || m_activity[var] > m_activity[best])) {
+                best = var;
+            }
+        }
+        return best;
+    }
+
+    void Cdcl::attach(int clauseIndex) {
+        auto & clause = m_clauses[clauseIndex];
+        m_watches[clause[0]].push_back(clauseIndex);
+        m_watches[clause[1]].push_back(clauseIndex);
+    }
+
+    long Cdcl::luby(long i) {
+        long size = 1;
+        int seq = 0;
+        while (size < i + 1) {
+            seq++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != i) {
+            size = (size - 1) >> 1;
+            seq--;
+            i = i % size;
+        }
+        return 1L << seq;
+    }
+
+    //========================================================================
+    // Class: SatSolver
+    //========================================================================
+
+    SatSolver::SatSolver(Board & board) :
+        m_cdcl(729),
+        m_layout(board.layout()),
+        m_exhausted(false)
+    {
+        encodeRules();
+        encodeBoard(board);
+    }
+
+    std::optional<std::shared_ptr<Board>> SatSolver::next() {
+        if (m_exhausted) {
+            return std::optional<std::shared_ptr<Board>>();
+        }
+        auto result = m_cdcl.solve();
+        if (result == Cdcl::Unknown) {
+            return std::optional<std::shared_ptr<Board>>();
+        }
+        if (result == Cdcl::Unsat) {
+            m_exhausted = true;
+            return std::optional<std::shared_ptr<Board>>();
+        }
+
+        auto solution = std::shared_ptr<Board>(new Board(m_layout));
+        for (int rowNo = 0; rowNo < 9; rowNo++) {
+            for (int colNo = 0; colNo < 9; colNo++) {
+                for (int value = 1; value <= 9; value++) {
+                    if (m_cdcl.modelValue(var(rowNo, colNo, value))) {
+                        solution->setValue(rowNo, colNo, value);
+                        break;
+                    }
+                }
+            }
+        }
+
+        exclude(*solution);
+        return std::optional<std::shared_ptr<Board>>(solution);
+    }
+
+    void SatSolver::exclude(Board & solution) {
+        std::vector<int> blocking;
+        solution.eachCell([&blocking](Cell & cell) {
+            if (cell.isSet()) {
+                blocking.push_back(Cdcl::lit(var(cell.row(), cell.col(), cell.value()), true));
+            }
+        });
+        m_cdcl.reset();
+        if (!m_cdcl.addClause(blocking)) {
+            m_exhausted = true;
+        }
+    }
+
+    void SatSolver::setSeed(unsigned seed) {
+        m_cdcl.randomize(seed);
+    }
+
+    void SatSolver::setStopFlag(const std::atomic<bool> * stopFlag) {
+        m_cdcl.setStopFlag(stopFlag);
+    }
+
+    void SatSolver::encodeRules() {
+        // Every cell has exactly one value.
+        for (int rowNo = 0; rowNo < 9; rowNo++) {
+            for (int colNo = 0; colNo < 9; colNo++) {
+                std::vector<int> atLeastOne;
+                for (int value = 1; value <= 9; value++) {
+                    atLeastOne.push_back(Cdcl::lit(var(rowNo, colNo, value), false));
+                    for (int other = value + 1; other <= 9; other++) {
+                        m_cdcl.addClause({
+                            Cdcl::lit(var(rowNo, colNo, value), true),
+                            Cdcl::lit(var(rowNo, colNo, other), true) });
+                    }
+                }
+                m_cdcl.addClause(atLeastOne);
+            }
+        }
+
+        // Every unit of the layout has each value exactly once.
+        for (int unitNo = 0; unitNo < m_layout->unitCount(); unitNo++) {
+            const int * cells = m_layout->unit(unitNo);
+            for (int value = 1; value <= 9; value++) {
+                std::vector<int> atLeastOne;
+                for (int i = 0; i < 9; i++) {
+                    int vi = var(cells[i] / 9, cells[i] % 9, value);
+                    atLeastOne.push_back(Cdcl::lit(vi, false));
+                    for (int j = i + 1; j < 9; j++) {
+                        int vj = var(cells[j] / 9, cells[j] % 9, value);
+                        m_cdcl.addClause({ Cdcl::lit(vi, true), Cdcl::lit(vj, true) });
+                    }
+                }
+                m_cdcl.addClause(atLeastOne);
+            }
+        }
+    }
+
+    void SatSolver::encodeBoard(Board & board) {
+        bool consistent = true;
+        board.eachCell([this, &consistent](Cell & cell) {
+            if (cell.isSet()) {
+                consistent &= m_cdcl.addClause({ Cdcl::lit(var(cell.row(), cell.col(), cell.value()), false) });
+            }
+            else {
+                // Carry over eliminations already made on the board.
+                for (int value = 1; value <= 9; value++) {
+                    if (cell.possibilities().find(value) == cell.possibilities().end()) {
+                        consistent &= m_cdcl.addClause({ Cdcl::lit(var(cell.row(), cell.col(), value), true) });
+                    }
+                }
+            }
+        });
+        if (!consistent) {
+            m_exhausted = true;
+        }
+    }
+
+    //========================================================================
+    // Class: FallbackSolver
+    //========================================================================
+
+    FallbackSolver::FallbackSolver(Board & board, long nodeBudget) :
+        m_board(board),
+        m_rules(board),
+        m_stopFlag(nullptr)
+    {
+        m_rules.setNodeBudget(nodeBudget);
+    }
+
+    std::optional<std::shared_ptr<Board>> FallbackSolver::next() {
+        if (!m_sat.has_value()) {
+            auto solution = m_rules.next();
+            if (solution.has_value()) {
+                m_found.push_back(*solution);
+                return solution;
+            }
+            if (!m_rules.budgetExceeded() || (m_stopFlag != nullptr && m_stopFlag->load())) {
+                return solution;
+            }
+
+            // The rule engine gave up, continue the enumeration without
+            // repeating the solutions it already returned.
+            m_sat.emplace(m_board);
+            m_sat->setStopFlag(m_stopFlag);
+            for (auto & found : m_found) {
+                m_sat->exclude(*found);
+            }
+            m_found.clear();
+        }
+        return m_sat->next();
+    }
+
+    void FallbackSolver::setAdaptive(bool adaptive) {
+        m_rules.setAdaptive(adaptive);
+    }
+
+    void FallbackSolver::setBranching(Solver::Branching branching) {
+        m_rules.setBranching(branching);
+    }
+
+    void FallbackSolver::setSeed(unsigned seed) {
+        m_rules.setSeed(seed);
+    }
+
+    void FallbackSolver::setStopFlag(const std::atomic<bool> * stopFlag) {
+        m_stopFlag = stopFlag;
+        m_rules.setStopFlag(stopFlag);
+        if (m_sat.has_value()) {
+            m_sat->setStopFlag(stopFlag);
+        }
+    }
+
+    bool FallbackSolver::usedFallback() {
+        return m_sat.has_value();
+    }
+};
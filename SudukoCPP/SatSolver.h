@@ -0,0 +1,166 @@
+/*
+SAT based solving engine for Suduko puzzles.
+
+The board is encoded as CNF over 729 variables (one per row, column and
+value) with constraints for every unit of the board's layout, and solved
+with a small self contained CDCL core. It enumerates solutions through the
+same next() interface as Solver by adding a blocking clause for every
+solution returned.
+*/
+#ifndef SAT_SOLVER_H
+#define SAT_SOLVER_H
+
+#include "Suduko.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Cdcl
+    //========================================================================
+
+    // A minimal conflict driven clause learning SAT solver.
+    // Literals are encoded as 2 * var for the positive literal and
+    // 2 * var + 1 for the negated literal.
+    class Cdcl {
+    public:
+        // Unknown when the search was stopped before it found an answer.
+        enum Result { Sat, Unsat, Unknown };
+
+    private:
+        int m_varCount;
+
+        // All clauses, original and learnt. The first two literals of a
+        // clause are the watched literals.
+        std::vector<std::vector<int>> m_clauses;
+
+        // Clause indexes watching each literal.
+        std::vector<std::vector<int>> m_watches;
+
+        // Assignment per variable: -1 unassigned, 0 false, 1 true.
+        std::vector<int8_t> m_values;
+        std::vector<int> m_levels;
+        std::vector<int> m_reasons;
+        std::vector<int8_t> m_phases;
+        std::vector<double> m_activity;
+        std::vector<int8_t> m_seen;
+
+        std::vector<int> m_trail;
+        std::vector<int> m_trailLimits;
+        size_t m_propagateHead;
+
+        double m_activityIncrement;
+        bool m_unsat;
+        long m_conflicts;
+        const std::atomic<bool> * m_stopFlag;
+
+    public:
+        Cdcl(int varCount);
+
+        // Adds a clause. May only be called at decision level 0.
+        // Returns false if the clause makes the formula unsatisfiable.
+        bool addClause(std::vector<int> lits);
+
+        // Searches for a satisfying assignment.
+        Result solve();
+
+        // The value of a variable after solve() returned Sat.
+        bool modelValue(int var);
+
+        // Backtracks to decision level 0 so new clauses can be added.
+        void reset();
+
+        long conflicts();
+
+        // Perturbs the initial variable order and phases, so differently
+        // seeded solvers explore the search space in a different order.
+        void randomize(unsigned seed);
+
+        // solve() returns Unknown once the flag is set.
+        void setStopFlag(const std::atomic<bool> * stopFlag);
+
+        static int lit(int var, bool negated) { return var * 2 + (negated ? 1 : 0); }
+
+    private:
+        int litValue(int lit);
+        int decisionLevel();
+        void enqueue(int lit, int reason);
+        int propagate();
+        void analyze(int conflict, std::vector<int> & learnt, int & backtrackLevel);
+        void backtrack(int level);
+        void bumpActivity(int var);
+        int pickBranchVariable();
+        void attach(int clauseIndex);
+        static long luby(long i);
+    };
+
+    //========================================================================
+    // Class: SatSolver
+    //========================================================================
+
+    class SatSolver {
+    private:
+        Cdcl m_cdcl;
+        std::shared_ptr<const Layout> m_layout;
+        bool m_exhausted;
+
+    public:
+        SatSolver(Board & board);
+
+        // Returns the next solution or an empty optional once all solutions
+        // have been produced.
+        std::optional<std::shared_ptr<Board>> next();
+
+        // Rule out a solution that was already found by another engine.
+        void exclude(Board & solution);
+
+        void setSeed(unsigned seed);
+
+        // next() gives up and returns no solution once the flag is set,
+        // without marking the enumeration as done.
+        void setStopFlag(const std::atomic<bool> * stopFlag);
+
+        static int var(int rowNo, int colNo, int value) { return (rowNo * 9 + colNo) * 9 + (value - 1); }
+
+    private:
+        void encodeRules();
+        void encodeBoard(Board & board);
+    };
+
+    //========================================================================
+    // Class: FallbackSolver
+    //========================================================================
+
+    // Runs the rule based Solver until it uses up its node budget and then
+    // switches over to the SatSolver for the rest of the enumeration.
+    class FallbackSolver {
+    private:
+        Board m_board;
+        Solver m_rules;
+        std::optional<SatSolver> m_sat;
+        std::vector<std::shared_ptr<Board>> m_found;
+        const std::atomic<bool> * m_stopFlag;
+
+    public:
+        FallbackSolver(Board & board, long nodeBudget);
+
+        std::optional<std::shared_ptr<Board>> next();
+
+        // Configure the rule engine that runs until the node budget is used.
+        void setAdaptive(bool adaptive);
+        void setBranching(Solver::Branching branching);
+        void setSeed(unsigned seed);
+
+        void setStopFlag(const std::atomic<bool> * stopFlag);
+
+        // Has the search switched over to the SAT engine?
+        bool usedFallback();
+    };
+};
+
+#endif
@@ -1,19 +1,20 @@
 #include "Suduko.h"
+#include "ResultWriter.h"
+#include "Tracer.h"
 
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <iterator>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <optional>
 #include <random>
-#include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
 
 namespace Suduko {
 
@@ -37,7 +38,7 @@ namespace Suduko {
         }
 
         m_value = _value;
-        m_possibilities.empty();
+        m_possibilities.clear();
         return true;
     }
 
@@ -93,8 +94,11 @@ namespace Suduko {
     // Class: Board
     //========================================================================
 
-    Board::Board() :
-        m_cells(9)
+    Board::Board(std::shared_ptr<const Layout> layout) :
+        m_cells(9),
+        m_layout(layout),
+        m_unitMasks{},
+        m_setCount(0)
     {
         for (int rowNo = 0; rowNo < 9; rowNo++) {
             m_cells.push_back(std::vector<Cell>());
@@ -105,7 +109,15 @@ namespace Suduko {
     }
 
     void Board::clear() {
-        eachCell([](auto cell) { cell.clear(); });
+        eachCell([](auto & cell) { cell.clear(); });
+        for (auto & mask : m_unitMasks) {
+            mask = 0;
+        }
+        m_setCount = 0;
+    }
+
+    std::shared_ptr<const Layout> Board::layout() {
+        return m_layout;
     }
 
     std::vector<Cell> Board::getCellsWithSinglePossibility() {
@@ -122,6 +134,10 @@ namespace Suduko {
         return m_cells[rowNo][colNo];
     }
 
+    Cell& Board::cell(int cellId) {
+        return m_cells[cellId / 9][cellId % 9];
+    }
+
     void Board::setValue(int rowNo, int colNo, int value) {
         if (!trySetValue(rowNo, colNo, value)) {
             throw std::invalid_argument("Could not set value for cell.");
@@ -130,9 +146,18 @@ namespace Suduko {
 
     bool Board::trySetValue(int rowNo, int colNo, int value) {
         auto & tCell = cell(rowNo, colNo);
-        if (!tCell.trySet(value)) {
+        if (tCell.isSet()) {
+            return tCell.value() == value;
+        }
+        if (!canPlace(rowNo, colNo, value) || !tCell.trySet(value)) {
             return false;
         }
+        uint16_t bit = 1 << (value - 1);
+        const int * units = m_layout->cellUnits(tCell.id());
+        for (int i = 0, count = m_layout->cellUnitCount(tCell.id()); i < count; i++) {
+            m_unitMasks[units[i]] |= bit;
+        }
+        m_setCount++;
         eachRelatedCell(rowNo, colNo, [value](auto & _cell) {
             _cell.removePossibility(value);
         });
@@ -140,17 +165,25 @@ namespace Suduko {
     }
 
     void Board::unset(int rowNo, int colNo) {
-        // TODO: There seems to be some bugs in this method or one of the methods it calls.
         auto & _cell = cell(rowNo, colNo);
         if (!_cell.isSet()) {
             return;
         }
+        int value = _cell.value();
+        uint16_t bit = 1 << (value - 1);
+        const int * units = m_layout->cellUnits(_cell.id());
+        for (int i = 0, count = m_layout->cellUnitCount(_cell.id()); i < count; i++) {
+            m_unitMasks[units[i]] &= ~bit;
+        }
+        m_setCount--;
         _cell.unset();
         recomputePossibilities(rowNo, colNo);
 
-        eachRelatedCell(rowNo, colNo, [this, rowNo, colNo](auto & relatedCell) {
-            if (!relatedCell.isSet()) {
-                recomputePossibilities(rowNo, colNo);
+        // The value is possible again in related cells unless another of
+        // their units still holds it.
+        eachRelatedCell(rowNo, colNo, [this, value](auto & relatedCell) {
+            if (!relatedCell.isSet() && canPlace(relatedCell.row(), relatedCell.col(), value)) {
+                relatedCell.addPossibility(value);
             }
         });
     }
@@ -167,84 +200,90 @@ namespace Suduko {
     }
 
     int Board::cellSetCount() {
-        int setCount = 0;
-        eachCell([&setCount](auto _cell) {
-            if (_cell.isSet()) {
-                setCount++;
-            }
+        return m_setCount;
+    }
+
+    int Board::possibilityCount() {
+        int count = 0;
+        eachCell([&count](Cell & cell) {
+            count += cell.possibilities().size();
         });
-        return setCount;
+        return count;
     }
 
     bool Board::isSolved() {
-        return cellSetCount() == 81;
+        return m_setCount == 81;
     }
 
-    std::string Board::display() {
-        std::stringstream str;
-
-        for (int rowNo = 0; rowNo < 9; rowNo++) {
-            if (rowNo == 3 || rowNo == 6) {
-                str << "---+---+---" << std::endl;
-            }
-            for (int colNo = 0; colNo < 9; colNo++) {
-                if (colNo == 3 || colNo == 6) {
-                    str << "|";
-                }
-                auto _cell = cell(rowNo, colNo);
-                if (!_cell.isSet()) {
-                    str << " ";
-                }
-                else {
-                    str << _cell.value();
-                }
-            }
-            str << std::endl;
+    bool Board::canPlace(int rowNo, int colNo, int value) {
+        if (value < 1 || value > 9) {
+            throw std::invalid_argument(std::string("Invalid value set: ") + std::to_string(value) + ".");
         }
+        uint16_t used = 0;
+        int cellId = rowNo * 9 + colNo;
+        const int * units = m_layout->cellUnits(cellId);
+        for (int i = 0, count = m_layout->cellUnitCount(cellId); i < count; i++) {
+            used |= m_unitMasks[units[i]];
+        }
+        return (used & (1 << (value - 1))) == 0;
+    }
 
-        return str.str();
+    void Board::toCompact(uint8_t * values) {
+        eachCell([values](Cell & _cell) {
+            values[_cell.id()] = _cell.value();
+        });
+    }
+
+    std::string Board::display() {
+        uint8_t values[81];
+        toCompact(values);
+        char grid[ResultWriter::GridSize];
+        return std::string(grid, ResultWriter::formatGrid(values, grid));
     }
 
     std::string Board::debugDisplay() {
-        std::stringstream content;
+        std::string content;
+        content.reserve(9 * 3 * 36 + 8 * 36);
 
         for (int rowNo = 0; rowNo < 9; rowNo++) {
-            std::stringstream lines[] = { std::stringstream(), std::stringstream(), std::stringstream() };
+            std::string lines[3];
 
             if (rowNo == 3 || rowNo == 6) {
-                content << "###################################" << std::endl;
+                content += "###################################\n";
             }
             else if (rowNo > 0) {
-                content << "---+---+---#---+---+---#---+---+---" << std::endl;
+                content += "---+---+---#---+---+---#---+---+---\n";
             }
 
             for (int colNo = 0; colNo < 9; colNo++) {
-                auto _cell = cell(rowNo, colNo);
+                auto & _cell = cell(rowNo, colNo);
 
                 if (colNo == 3 || colNo == 6) {
-                    lines[0] << "#";
-                    lines[1] << "#";
-                    lines[2] << "#";
+                    lines[0] += '#';
+                    lines[1] += '#';
+                    lines[2] += '#';
                 }
                 else if (colNo > 0) {
-                    lines[0] << "|";
-                    lines[1] << "|";
-                    lines[2] << "|";
+                    lines[0] += '|';
+                    lines[1] += '|';
+                    lines[2] += '|';
                 }
 
                 if (_cell.isSet()) {
-                    lines[0] << " v ";
-                    lines[1] << ">" << _cell.value() << "<";
-                    lines[2] << " ^ ";
+                    lines[0] += " v ";
+                    lines[1] += '>';
+                    lines[1] += static_cast<char>('0' + _cell.value());
+                    lines[1] += '<';
+                    lines[2] += " ^ ";
                 }
                 else {
                     for (int _pVal = 1; _pVal <= 9; _pVal++) {
                         int lineNo = (_pVal - 1) / 3;
                         if (_cell.possibilities().find(_pVal) != _cell.possibilities().end()) {
-                            lines[lineNo] << _pVal;
+                            lines[lineNo] += static_cast<char>('0' + _pVal);
                         }
                         else {
-                            lines[lineNo] << " ";
+                            lines[lineNo] += ' ';
                         }
                     }
                 }
@@ -252,46 +291,124 @@ namespace Suduko {
             }
 
             for (int lineNo = 0; lineNo < 3; lineNo++) {
-                content << lines[lineNo].str() << std::endl;
+                content += lines[lineNo];
+                content += '\n';
             }
         }
 
-        return content.str();
+        return content;
     }
 
     //========================================================================
     // Class: Solver
     //========================================================================
 
+    const Solver::RuleInfo Solver::rules[Solver::RuleCount] = {
+        { &Solver::simplificationRuleSinglePossibility, "single possibility" },
+        { &Solver::simplificationRuleOnlyPossibility, "only possibility" },
+        { &Solver::simplificationRuleBoxCheck, "box check" },
+        { &Solver::simplificationRuleSharedPossibilities, "shared possibilities" }
+    };
+
     Solver::Solver(Board & board) :
-        generator(std::chrono::system_clock::now().time_since_epoch().count())
+        generator(std::chrono::system_clock::now().time_since_epoch().count()),
+        nodeCount(0),
+        nodeBudget(-1),
+        tracer(nullptr),
+        currentNode(-1),
+        adaptive(true),
+        branching(FirstFewest),
+        stopFlag(nullptr)
     {
+        for (int ruleNo = 0; ruleNo < RuleCount; ruleNo++) {
+            ruleStats[ruleNo] = RuleStats{ 0.0, 0, 0 };
+            ruleOrder[ruleNo] = ruleNo;
+        }
         auto _board = std::shared_ptr<Board>(new Board(board));
-        boards.push([_board]() { return std::optional<std::shared_ptr<Board>>(_board); });
+        boards.push(Attempt{ [_board]() { return std::optional<std::shared_ptr<Board>>(_board); }, -1, 0, -1, 0 });
     }
 
     std::optional<std::shared_ptr<Board>> Solver::next() {
         while (!boards.empty()) {
-            auto optBoard = boards.top()();
+            if (budgetExceeded()) {
+                break;
+            }
+            if (stopFlag != nullptr && stopFlag->load(std::memory_order_relaxed)) {
+                break;
+            }
+            currentNode = nodeCount++;
+            auto attempt = boards.top();
             boards.pop();
+            int64_t start = (tracer != nullptr) ? tracer->now() : 0;
+
+            std::optional<std::shared_ptr<Board>> solution;
+            auto optBoard = attempt.factory();
             if (optBoard.has_value()) {
                 auto b = *optBoard;
-                simplify(*b);
+                auto simplified = simplify(*b);
                 if (b->isSolved()) {
-                    return std::optional<std::shared_ptr<Board>>(b);
+                    solution = b;
+                    if (tracer != nullptr) {
+                        tracer->solution(currentNode);
+                    }
                 }
                 else {
                     auto solveCell = getCellToSolve(*b);
                     if (solveCell.has_value()) {
-                        pushSolutionAttempts(b, *solveCell);
+                        if (tracer != nullptr && simplified != Solver::Invalid && solveCell->possibilities().empty()) {
+                            tracer->contradiction(currentNode, "empty cell");
+                        }
+                        pushSolutionAttempts(b, *solveCell, currentNode, attempt.depth + 1);
                     }
                 }
             }
+            else if (tracer != nullptr) {
+                tracer->contradiction(currentNode, "set value");
+            }
+
+            if (tracer != nullptr) {
+                tracer->node(currentNode, attempt.parent, attempt.depth, attempt.cellId, attempt.value, start);
+            }
+            if (solution.has_value()) {
+                return solution;
+            }
         }
         return std::optional<std::shared_ptr<Board>>();
     }
 
-    void Solver::pushSolutionAttempts(std::shared_ptr<Board> board, Cell & solveCell) {
+    void Solver::setNodeBudget(long budget) {
+        nodeBudget = budget;
+    }
+
+    bool Solver::budgetExceeded() {
+        return nodeBudget >= 0 && nodeCount >= nodeBudget && !boards.empty();
+    }
+
+    void Solver::setTracer(Tracer * _tracer) {
+        tracer = _tracer;
+    }
+
+    void Solver::setAdaptive(bool _adaptive) {
+        adaptive = _adaptive;
+        for (int ruleNo = 0; ruleNo < RuleCount; ruleNo++) {
+            ruleStats[ruleNo].skip = 0;
+            ruleOrder[ruleNo] = ruleNo;
+        }
+    }
+
+    void Solver::setBranching(Branching _branching) {
+        branching = _branching;
+    }
+
+    void Solver::setSeed(unsigned seed) {
+        generator.seed(seed);
+    }
+
+    void Solver::setStopFlag(const std::atomic<bool> * _stopFlag) {
+        stopFlag = _stopFlag;
+    }
+
+    void Solver::pushSolutionAttempts(std::shared_ptr<Board> board, Cell & solveCell, int parent, int depth) {
         auto solveCellPtr = std::shared_ptr<Cell>(new Cell(solveCell));
 
         std::vector<int> setValues(solveCellPtr->possibilities().size());
@@ -299,7 +416,7 @@ namespace Suduko {
         std::shuffle(setValues.begin(), setValues.end(), generator);
 
         for (auto setValue : setValues) {
-            boards.push([solveCellPtr, board, setValue]() {
+            auto factory = [solveCellPtr, board, setValue]() {
                 auto newBoard = std::shared_ptr<Board>(new Board(*board));
                 if (newBoard->trySetValue(solveCellPtr->row(), solveCellPtr->col(), setValue)) {
                     return std::optional<std::shared_ptr<Board>>(newBoard);
@@ -307,7 +424,8 @@ namespace Suduko {
                 else {
                     return std::optional<std::shared_ptr<Board>>();
                 }
-            });
+            };
+            boards.push(Attempt{ factory, parent, depth, solveCellPtr->id(), setValue });
         }
         //if (setValues.size() > 0) {
         //    std::cout << "Pushed new solution search nodes: added=" << setValues.size() << " current search size=" << boards.size() << std::endl;
@@ -316,23 +434,32 @@ namespace Suduko {
 
     std::optional<Cell> Solver::getCellToSolve(Board & board) {
         std::optional<Cell> solveCell;
-        board.eachCell([&solveCell](auto & _cell) {
+        int ties = 0;
+        board.eachCell([this, &solveCell, &ties](auto & _cell) {
             if (!_cell.isSet()) {
                 if (!solveCell.has_value() || _cell.possibilities().size() < solveCell->possibilities().size()) {
                     solveCell = _cell;
+                    ties = 1;
+                }
+                else if (branching == RandomFewest && _cell.possibilities().size() == solveCell->possibilities().size()) {
+                    // Keep each of the tied cells with equal chance.
+                    ties++;
+                    if (std::uniform_int_distribution<int>(0, ties - 1)(generator) == 0) {
+                        solveCell = _cell;
+                    }
                 }
             }
         });
         return solveCell;
     }
 
-    void Solver::simplify(Board & board) {
+    Solver::RuleResult Solver::simplify(Board & board) {
         while (true) {
             switch (runSimplificationRules(board)) {
             case Solver::Invalid:
-                return;
+                return Solver::Invalid;
             case Solver::NoAction:
-                return;
+                return Solver::NoAction;
             case Solver::Updated:
                 break;
             }
@@ -340,15 +467,16 @@ namespace Suduko {
     }
 
     Solver::RuleResult Solver::runSimplificationRules(Board & board) {
-        // TODO: make this a constant.
-        std::vector<Solver::Rule> rules{
-            &Solver::simplificationRuleSinglePossibility,
-            &Solver::simplificationRuleOnlyPossibility,
-            &Solver::simplificationRuleBoxCheck,
-            &Solver::simplificationRuleSharedPossibilities
-        };
-        for (auto rule : rules) {
-            switch ((this->*rule)(board)) {
+        for (int pos = 0; pos < RuleCount; pos++) {
+            int ruleNo = ruleOrder[pos];
+            if (ruleStats[ruleNo].skip > 0) {
+                // Backed off. Propagation moves on to search without it.
+                ruleStats[ruleNo].skip--;
+                continue;
+            }
+
+            auto result = runRule(ruleNo, board);
+            switch (result) {
             case Solver::Invalid:
                 return Solver::Invalid;
             case Solver::Updated:
@@ -363,6 +491,48 @@ namespace Suduko {
         return Solver::NoAction;
     }
 
+    Solver::RuleResult Solver::runRule(int ruleNo, Board & board) {
+        int64_t traceStart = (tracer != nullptr) ? tracer->now() : 0;
+        int before = adaptive ? board.possibilityCount() : 0;
+        auto start = std::chrono::steady_clock::now();
+
+        auto result = (this->*rules[ruleNo].rule)(board);
+
+        if (adaptive) {
+            auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            updateRuleStats(ruleNo, result, before - board.possibilityCount(), nanoseconds);
+        }
+        if (tracer != nullptr) {
+            tracer->rule(currentNode, rules[ruleNo].name, result == Solver::Updated, traceStart);
+            if (result == Solver::Invalid) {
+                tracer->contradiction(currentNode, rules[ruleNo].name);
+            }
+        }
+        return result;
+    }
+
+    void Solver::updateRuleStats(int ruleNo, RuleResult result, int removed, int64_t nanoseconds) {
+        auto & stats = ruleStats[ruleNo];
+        stats.yield = stats.yield * 0.75 + 0.25 * removed / static_cast<double>(std::max<int64_t>(nanoseconds, 1));
+
+        // Single possibility is the cheapest rule and what the others feed,
+        // so only the other rules are backed off.
+        if (result == Solver::NoAction && ruleNo != 0) {
+            stats.backoff = std::min(std::max(stats.backoff * 2, 1), static_cast<int>(MaxBackoff));
+            stats.skip = stats.backoff;
+        }
+        else if (result == Solver::Updated) {
+            stats.backoff = 0;
+        }
+
+        // Keep the rules sorted by yield, best first.
+        for (int pos = 1; pos < RuleCount; pos++) {
+            for (int back = pos; back > 0 && ruleStats[ruleOrder[back]].yield > ruleStats[ruleOrder[back - 1]].yield; back--) {
+                std::swap(ruleOrder[back], ruleOrder[back - 1]);
+            }
+        }
+    }
+
     Solver::RuleResult Solver::simplificationRuleSinglePossibility(Board & board) {
         auto spCells = board.getCellsWithSinglePossibility();
         for (auto spCell : spCells) {
@@ -375,18 +545,15 @@ namespace Suduko {
     }
 
     Solver::RuleResult Solver::simplificationRuleOnlyPossibility(Board & board) {
-        std::map<std::tuple<Board::Region, int, int>, std::vector<std::shared_ptr<Cell>>> tracking;
+        std::map<std::tuple<int, int>, std::vector<std::shared_ptr<Cell>>> tracking;
+        auto layout = board.layout();
 
-        board.eachCell([&tracking](Cell & cell) {
+        board.eachCell([&tracking, &layout](Cell & cell) {
             if (!cell.isSet()) {
-                std::vector<std::tuple<Board::Region, int>> regions{ 
-                    std::tuple<Board::Region, int>(Board::Row, cell.row()),
-                    std::tuple<Board::Region, int>(Board::Col, cell.col()),
-                    std::tuple<Board::Region, int>(Board::Box, cell.box())
-                };
+                const int * units = layout->cellUnits(cell.id());
                 for (auto setValue : cell.possibilities()) {
-                    for (auto region : regions) {
-                        auto k = std::make_tuple(std::get<0>(region), std::get<1>(region), setValue);
+                    for (int i = 0; i < layout->cellUnitCount(cell.id()); i++) {
+                        auto k = std::make_tuple(units[i], setValue);
                         auto elemIter = tracking.find(k);
                         if (elemIter == tracking.end()) {
                             tracking[k] = std::vector<std::shared_ptr<Cell>>();
@@ -401,7 +568,7 @@ namespace Suduko {
         for (auto & pair : tracking) {
             if (pair.second.size() == 1) {
                 auto cell = pair.second[0];
-                auto setValue = std::get<2>(pair.first);
+                auto setValue = std::get<1>(pair.first);
                 if (!board.trySetValue(cell->row(), cell->col(), setValue)) {
                     return Solver::Invalid;
                 }
@@ -413,20 +580,14 @@ namespace Suduko {
     }
 
     Solver::RuleResult Solver::simplificationRuleSharedPossibilities(Board & board) {
-        std::map<std::tuple<Board::Region, int, std::set<int>>, std::set<int>> tracking;
+        std::map<std::tuple<int, std::set<int>>, std::set<int>> tracking;
+        auto layout = board.layout();
 
-        board.eachCell([&tracking](Cell & cell) {
+        board.eachCell([&tracking, &layout](Cell & cell) {
             if (!cell.isSet()) {
-                std::vector<std::tuple<Board::Region, int>> regions{
-                    std::tuple<Board::Region, int>(Board::Row, cell.row()),
-                    std::tuple<Board::Region, int>(Board::Col, cell.col()),
-                    std::tuple<Board::Region, int>(Board::Box, cell.box())
-                };
-                for (auto & pair : regions) {
-                    auto key = std::make_tuple(
-                        std::get<0>(pair),
-                        std::get<1>(pair),
-                        cell.possibilities());
+                const int * units = layout->cellUnits(cell.id());
+                for (int i = 0; i < layout->cellUnitCount(cell.id()); i++) {
+                    auto key = std::make_tuple(units[i], cell.possibilities());
 
                     auto iter = tracking.find(key);
                     if (iter == tracking.end()) {
@@ -439,13 +600,12 @@ namespace Suduko {
 
         int updateCount = 0;
         for (auto & pair : tracking) {
-            auto region = std::get<0>(pair.first);
-            auto regionValue = std::get<1>(pair.first);
+            auto unitNo = std::get<0>(pair.first);
 
-            if (std::get<2>(pair.first).size() == pair.second.size()) {
-                board.eachCellInRegion(region, regionValue, [&board, &updateCount, &pair](Cell & cell) {
+            if (std::get<1>(pair.first).size() == pair.second.size()) {
+                board.eachCellInUnit(unitNo, [&board, &updateCount, &pair](Cell & cell) {
                     if (!cell.isSet() && pair.second.find(cell.id()) == pair.second.end()) {
-                        for (auto pValue : std::get<2>(pair.first)) {
+                        for (auto pValue : std::get<1>(pair.first)) {
                             if (cell.possibilities().find(pValue) != cell.possibilities().end()) {
                                 cell.removePossibility(pValue);
                                 updateCount++;
@@ -460,42 +620,42 @@ namespace Suduko {
     }
 
     Solver::RuleResult Solver::simplificationRuleBoxCheck(Board & board) {
+        // When every place for a value in one unit also lies in a second
+        // unit, the value can be removed from the rest of the second unit.
+        // For the standard layout this covers a box locking a value into a
+        // row or column and a row or column locking it into a box.
         int updateCount = 0;
+        auto layout = board.layout();
 
-        for (int boxNo = 0; boxNo < 9; boxNo++) {
-            std::unordered_map<int, std::set<int>> valRows;
-            std::unordered_map<int, std::set<int>> valCols;
-            board.eachCellInBox(boxNo, [&valRows, &valCols](auto & cell) {
+        for (int unitNo = 0; unitNo < layout->unitCount(); unitNo++) {
+            std::map<int, std::set<int>> valCells;
+            board.eachCellInUnit(unitNo, [&valCells](auto & cell) {
                 if (!cell.isSet()) {
                     for (auto pValue : cell.possibilities()) {
-                        if (valRows.find(pValue) == valRows.end()) {
-                            valRows[pValue] = std::set<int>();
-                        }
-                        if (valCols.find(pValue) == valCols.end()) {
-                            valCols[pValue] = std::set<int>();
-                        }
-                        valRows[pValue].insert(cell.row());
-                        valCols[pValue].insert(cell.col());
+                        valCells[pValue].insert(cell.id());
                     }
                 }
             });
 
-            for (auto & pair : valRows) {
-                if (pair.second.size() == 1) {
-                    board.eachCellInRow(*pair.second.begin(), [&updateCount, &pair, boxNo](Cell & cell) {
-                        if (!cell.isSet() && cell.box() != boxNo) {
-                            if (cell.possibilities().find(pair.first) != cell.possibilities().end()) {
-                                cell.removePossibility(pair.first);
-                                updateCount++;
-                            }
-                        }
+            for (auto & pair : valCells) {
+                int firstId = *pair.second.begin();
+                const int * firstUnits = layout->cellUnits(firstId);
+                for (int i = 0; i < layout->cellUnitCount(firstId); i++) {
+                    int otherUnit = firstUnits[i];
+                    if (otherUnit == unitNo) {
+                        continue;
+                    }
+
+                    bool shared = std::all_of(pair.second.begin(), pair.second.end(), [&layout, otherUnit](int cellId) {
+                        const int * units = layout->cellUnits(cellId);
+                        return std::find(units, units + layout->cellUnitCount(cellId), otherUnit) != units + layout->cellUnitCount(cellId);
                     });
-                }
-            }
-            for (auto & pair : valCols) {
-                if (pair.second.size() == 1) {
-                    board.eachCellInCol(*pair.second.begin(), [&updateCount, &pair, boxNo](Cell & cell) {
-                        if (!cell.isSet() && cell.box() != boxNo) {
+                    if (!shared) {
+                        continue;
+                    }
+
+                    board.eachCellInUnit(otherUnit, [&updateCount, &pair](Cell & cell) {
+                        if (!cell.isSet() && pair.second.find(cell.id()) == pair.second.end()) {
                             if (cell.possibilities().find(pair.first) != cell.possibilities().end()) {
                                 cell.removePossibility(pair.first);
                                 updateCount++;
@@ -513,14 +673,15 @@ namespace Suduko {
     // Class: Generator
     //========================================================================
 
-    Generator::Generator() :
-        generator(std::chrono::system_clock::now().time_since_epoch().count())
+    Generator::Generator(std::shared_ptr<const Layout> _layout) :
+        generator(std::chrono::system_clock::now().time_since_epoch().count()),
+        layout(_layout)
     {
-        Board empty;
+        Board empty(layout);
         Solver solver(empty);
         auto solution = solver.next();
         if (!solution.has_value()) {
-            throw std::exception("Could not generate a new Suduko board.");
+            throw std::runtime_error("Could not generate a new Suduko board.");
         }
         for (int i = 0; i < 81; i++) {
             ids.push_back(i);
@@ -548,7 +709,7 @@ namespace Suduko {
                 if (index < ids.size()) {
                     boards.push(std::make_tuple(board, index + 1));
                     int cellId = ids[index];
-                    auto newBoard = std::shared_ptr<Board>(new Board());
+                    auto newBoard = std::shared_ptr<Board>(new Board(layout));
                     board->eachCell([&newBoard, cellId](auto & _cell) {
                         if (_cell.isSet() && _cell.id() != cellId) {
                             newBoard->setValue(_cell.row(), _cell.col(), _cell.value());
@@ -577,13 +738,13 @@ namespace Suduko {
     // Standalone Functions
     //========================================================================
 
-    std::shared_ptr<Board> loadFromFile(const std::string & filePath) {
+    std::shared_ptr<Board> loadFromFile(const std::string & filePath, std::shared_ptr<const Layout> layout) {
         std::ifstream input(filePath);
         if (!input.is_open()) {
             throw std::invalid_argument(std::string("Could not open file: ") + filePath);
         }
 
-        auto board = std::shared_ptr<Board>(new Board());
+        auto board = std::shared_ptr<Board>(new Board(layout));
         std::string line;
         int rowNo = 0;
         while (std::getline(input, line) && rowNo < 9) {
@@ -604,4 +765,53 @@ namespace Suduko {
         }
         return board;
     }
+
+    std::vector<uint8_t> loadLinesFromFile(const std::string & filePath, std::vector<size_t> * lineNumbers) {
+        std::ifstream input(filePath, std::ios::binary);
+        if (!input.is_open()) {
+            throw std::invalid_argument(std::string("Could not open file: ") + filePath);
+        }
+        std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+        std::vector<uint8_t> puzzles;
+        puzzles.reserve(content.size() / 82 * 81 + 81);
+        size_t lineNo = 0;
+        size_t pos = 0;
+        while (pos < content.size()) {
+            size_t end = content.find('\n', pos);
+            if (end == std::string::npos) {
+                end = content.size();
+            }
+            size_t length = end - pos;
+            if (length > 0 && content[end - 1] == '\r') {
+                length--;
+            }
+            lineNo++;
+
+            if (length > 0) {
+                if (length < 81) {
+                    throw std::invalid_argument(std::string("Invalid puzzle on line ") + std::to_string(lineNo) + " of " + filePath);
+                }
+                for (size_t i = 0; i < 81; i++) {
+                    char c = content[pos + i];
+                    puzzles.push_back((c >= '1' && c <= '9') ? c - '0' : 0);
+                }
+                if (lineNumbers != nullptr) {
+                    lineNumbers->push_back(lineNo);
+                }
+            }
+            pos = end + 1;
+        }
+        return puzzles;
+    }
+
+    std::shared_ptr<Board> loadFromCompact(const uint8_t * values, std::shared_ptr<const Layout> layout) {
+        auto board = std::shared_ptr<Board>(new Board(layout));
+        for (int cellId = 0; cellId < 81; cellId++) {
+            if (values[cellId] != 0) {
+                board->setValue(cellId / 9, cellId % 9, values[cellId]);
+            }
+        }
+        return board;
+    }
 };
@@ -4,6 +4,10 @@ Library for solving and creating Suduko puzzles.
 #ifndef SUDUKO_H
 #define SUDUKO_H
 
+#include "Layout.h"
+
+#include <atomic>
+#include <cstdint>
 #include <optional>
 #include <functional>
 #include <memory>
@@ -17,6 +21,7 @@ namespace Suduko {
 
     // Pre-declare types.
     class Board;
+    class Tracer;
 
     // Alias used for the 2-d matrix of a Suduko board.
     template <typename T>
@@ -94,14 +99,24 @@ namespace Suduko {
         */
         Matrix<Cell> m_cells;
 
-    public:
+        // The units the board is checked against.
+        std::shared_ptr<const Layout> m_layout;
 
-        enum Region { Row, Col, Box };
+        // Bit masks of the values set in each unit of the layout.
+        // Bit (value - 1) is set when the value is used in the unit.
+        uint16_t m_unitMasks[Layout::MaxUnits];
+
+        // Number of set cells.
+        int m_setCount;
+
+    public:
 
         /**
         * Construct a new board.
         */
-        Board();
+        Board(std::shared_ptr<const Layout> layout = Layout::standard());
+
+        std::shared_ptr<const Layout> layout();
 
         void clear();
 
@@ -111,6 +126,8 @@ namespace Suduko {
 
         Cell& cell(int rowNo, int colNo);
 
+        Cell& cell(int cellId);
+
         void setValue(int rowNo, int colNo, int value);
 
         bool trySetValue(int rowNo, int colNo, int value);
@@ -121,8 +138,21 @@ namespace Suduko {
 
         int cellSetCount();
 
+        // Total number of possible values left over all unset cells.
+        int possibilityCount();
+
+        // Is every cell set? Values are checked against the unit masks when
+        // they are set so a full board is always a valid solution.
         bool isSolved();
 
+        // Can the value be set at the cell without repeating a value in any
+        // of its units?
+        bool canPlace(int rowNo, int colNo, int value);
+
+        // Writes the board in compact form: 81 values in row major order
+        // with 0 for unset cells.
+        void toCompact(uint8_t * values);
+
         template <typename Func>
         void eachCell(Func f) {
             for (auto & row : m_cells) {
@@ -133,17 +163,9 @@ namespace Suduko {
         }
 
         template <typename Func>
-        void eachCellInRegion(Region region, int regionNum, Func f) {
-            switch (region) {
-            case Row:
-                eachCellInRow(regionNum, f);
-                break;
-            case Col:
-                eachCellInCol(regionNum, f);
-                break;
-            case Box:
-                eachCellInBox(regionNum, f);
-                break;
+        void eachCellInUnit(int unitNo, Func f) {
+            for (int i = 0; i < 9; i++) {
+                f(cell(m_layout->unit(unitNo)[i]));
             }
         }
 
@@ -174,24 +196,14 @@ namespace Suduko {
             }
         }
 
+        // Visits every cell sharing a unit with the cell.
         template <typename Func>
         void eachRelatedCell(int rowNo, int colNo, Func f) {
-            auto & tCell = cell(rowNo, colNo);
-            eachCellInRow(rowNo, [colNo, &f](auto & _cell) {
-                if (_cell.col() != colNo) {
-                    f(_cell);
-                }
-            });
-            eachCellInCol(colNo, [rowNo, &f](auto & _cell) {
-                if (_cell.row() != rowNo) {
-                    f(_cell);
-                }
-            });
-            eachCellInBox(tCell.box(), [rowNo, colNo, &f](auto & _cell) {
-                if (_cell.row() != rowNo && _cell.col() != colNo) {
-                    f(_cell);
-                }
-            });
+            int cellId = rowNo * 9 + colNo;
+            const int * peers = m_layout->peers(cellId);
+            for (int i = 0, count = m_layout->peerCount(cellId); i < count; i++) {
+                f(cell(peers[i]));
+            }
         }
     private:
         void recomputePossibilities(int rowNo, int colNo);
@@ -202,26 +214,96 @@ namespace Suduko {
     //========================================================================
 
     class Solver {
+    public:
+        // How the cell to branch on is picked among the unset cells with
+        // the fewest possibilities.
+        enum Branching { FirstFewest, RandomFewest };
+
     private:
         enum RuleResult { Updated, NoAction, Invalid };
         typedef Solver::RuleResult(Solver::*Rule)(Board &);
 
-        std::stack<BoardFactory> boards;
+        // A search node waiting to be expanded and where it sits in the search tree.
+        struct Attempt {
+            BoardFactory factory;
+            int parent;
+            int depth;
+            int cellId;
+            int value;
+        };
+
+        struct RuleInfo {
+            Rule rule;
+            const char * name;
+        };
+
+        // How well a rule has been paying off during this solve.
+        struct RuleStats {
+            // Moving average of possibilities removed per nanosecond.
+            double yield;
+
+            // Runs to skip after coming up empty. Doubles each empty run
+            // up to MaxBackoff and resets once the rule makes progress.
+            int backoff;
+            int skip;
+        };
+
+        static const int RuleCount = 4;
+        static const int MaxBackoff = 32;
+        static const RuleInfo rules[RuleCount];
+
+        std::stack<Attempt> boards;
         std::default_random_engine generator;
+        long nodeCount;
+        long nodeBudget;
+        Tracer * tracer;
+        int currentNode;
+        bool adaptive;
+        Branching branching;
+        const std::atomic<bool> * stopFlag;
+        RuleStats ruleStats[RuleCount];
+        int ruleOrder[RuleCount];
 
     public:
         Solver(Board & board);
         std::optional<std::shared_ptr<Board>> next();
 
+        // Limits the number of search nodes next() may expand.
+        // A negative budget means no limit.
+        void setNodeBudget(long budget);
+
+        // Did the last call to next() stop because the node budget ran out?
+        bool budgetExceeded();
+
+        // Records search events to the tracer. The tracer must outlive the
+        // solver, nullptr turns tracing off.
+        void setTracer(Tracer * tracer);
+
+        // With adaptive scheduling (the default) the simplification rules
+        // run in order of their measured yield and rules that keep coming up
+        // empty are backed off. Otherwise they always run in a fixed order.
+        void setAdaptive(bool adaptive);
+
+        void setBranching(Branching branching);
+
+        // Seeds the random order in which the values of a branch are tried.
+        void setSeed(unsigned seed);
+
+        // next() gives up and returns no solution once the flag is set. The
+        // flag must outlive the solver, nullptr means never stop.
+        void setStopFlag(const std::atomic<bool> * stopFlag);
+
     private:
         std::optional<Cell> getCellToSolve(Board & board);
-        void simplify(Board & board);
+        RuleResult simplify(Board & board);
         RuleResult runSimplificationRules(Board & board);
+        RuleResult runRule(int ruleNo, Board & board);
+        void updateRuleStats(int ruleNo, RuleResult result, int removed, int64_t nanoseconds);
         RuleResult simplificationRuleSinglePossibility(Board & board);
         RuleResult simplificationRuleOnlyPossibility(Board & board);
         RuleResult simplificationRuleSharedPossibilities(Board & board);
         RuleResult simplificationRuleBoxCheck(Board & board);
-        void pushSolutionAttempts(std::shared_ptr<Board> board, Cell & cell);
+        void pushSolutionAttempts(std::shared_ptr<Board> board, Cell & cell, int parent, int depth);
     };
 
     //========================================================================
@@ -233,13 +315,14 @@ namespace Suduko {
         std::vector<int> ids;
         std::stack<std::tuple<std::shared_ptr<Board>, int>> boards;
         std::default_random_engine generator;
+        std::shared_ptr<const Layout> layout;
 
     public:
-        Generator();
+        Generator(std::shared_ptr<const Layout> layout = Layout::standard());
         std::optional<std::shared_ptr<Board>> generate();
 
     private:
-        bool Generator::hasSingleSolution(std::shared_ptr<Board> board);
+        bool hasSingleSolution(std::shared_ptr<Board> board);
     };
 
     //========================================================================
@@ -247,7 +330,17 @@ namespace Suduko {
     //========================================================================
 
     // Loads a board from a file.
-    std::shared_ptr<Board> loadFromFile(const std::string & filePath);
+    std::shared_ptr<Board> loadFromFile(const std::string & filePath, std::shared_ptr<const Layout> layout = Layout::standard());
+
+    // Loads puzzles stored one per line as 81 characters, where 1-9 are set
+    // values and any other character is an unset cell. Blank lines are
+    // skipped. Returns the puzzles back to back in compact form. When
+    // lineNumbers is given it receives the line, starting at 1, of each
+    // puzzle.
+    std::vector<uint8_t> loadLinesFromFile(const std::string & filePath, std::vector<size_t> * lineNumbers = nullptr);
+
+    // Creates a board from its compact form.
+    std::shared_ptr<Board> loadFromCompact(const uint8_t * values, std::shared_ptr<const Layout> layout = Layout::standard());
 };
 
 #endif
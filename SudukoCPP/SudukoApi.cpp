@@ -0,0 +1,211 @@
+#include "SudukoApi.h"
+#include "Enumerator.h"
+#include "LaneSolver.h"
+#include "Layout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using Suduko::Enumerator;
+    using Suduko::LaneSolver;
+    using Suduko::Layout;
+
+    // Reads the fields the caller knows about on top of the defaults.
+    sudoku_options readOptions(const sudoku_options * options) {
+        sudoku_options result;
+        sudoku_default_options(&result);
+        if (options != nullptr) {
+            if (options->size < sizeof(uint32_t)) {
+                throw std::invalid_argument("Invalid options size.");
+            }
+            std::memcpy(&result, options, std::min<size_t>(options->size, sizeof(result)));
+            result.size = sizeof(result);
+        }
+        if ((result.variants & ~(SUDOKU_VARIANT_X | SUDOKU_VARIANT_WINDOKU)) != 0) {
+            throw std::invalid_argument("Unknown variant.");
+        }
+        return result;
+    }
+
+    // Layouts without jigsaw regions are built once and shared by all calls.
+    std::shared_ptr<const Layout> layoutFor(const sudoku_options & options) {
+        static const char * variantNames[] = { "", "x", "windoku", "x+windoku" };
+        if (options.regions != nullptr) {
+            std::vector<int> regions(options.regions, options.regions + 81);
+            return Layout::create(variantNames[options.variants], regions);
+        }
+
+        static const std::shared_ptr<const Layout> layouts[] = {
+            Layout::standard(),
+            Layout::create(variantNames[1]),
+            Layout::create(variantNames[2]),
+            Layout::create(variantNames[3])
+        };
+        return layouts[options.variants];
+    }
+
+    template <typename Func>
+    int guard(Func f) {
+        try {
+            f();
+            return SUDOKU_OK;
+        }
+        catch (const std::invalid_argument &) {
+            return SUDOKU_ERROR_INVALID_ARGUMENT;
+        }
+        catch (...) {
+            return SUDOKU_ERROR_INTERNAL;
+        }
+    }
+
+    void solveRange(const uint8_t * puzzles, uint8_t * solutions, uint8_t * solved, size_t count, std::shared_ptr<const Layout> layout) {
+        LaneSolver laneSolver(layout);
+        bool laneSolved[LaneSolver::Lanes];
+        for (size_t first = 0; first < count; first += LaneSolver::Lanes) {
+            size_t lanes = std::min<size_t>(LaneSolver::Lanes, count - first);
+            laneSolver.solve(puzzles + first * 81, lanes, solutions + first * 81, laneSolved);
+            for (size_t lane = 0; lane < lanes; lane++) {
+                solved[first + lane] = laneSolved[lane] ? 1 : 0;
+            }
+        }
+    }
+}
+
+extern "C" {
+
+    void sudoku_default_options(sudoku_options * options) {
+        if (options != nullptr) {
+            options->size = sizeof(sudoku_options);
+            options->variants = 0;
+            options->regions = nullptr;
+            options->threads = 1;
+        }
+    }
+
+    int sudoku_abi_version(void) {
+        return SUDOKU_ABI_VERSION;
+    }
+
+    int sudoku_solve(const uint8_t puzzle[81], uint8_t solution[81], int * solved, const sudoku_options * options) {
+        return guard([&]() {
+            if (puzzle == nullptr || solution == nullptr || solved == nullptr) {
+                throw std::invalid_argument("Missing buffer.");
+            }
+            auto settings = readOptions(options);
+            Enumerator enumerator(puzzle, layoutFor(settings));
+            *solved = (enumerator.solve(solution) == 1) ? 1 : 0;
+        });
+    }
+
+    int sudoku_count(const uint8_t puzzle[81], uint64_t limit, uint64_t * count, const sudoku_options * options) {
+        return guard([&]() {
+            if (puzzle == nullptr || count == nullptr) {
+                throw std::invalid_argument("Missing buffer.");
+            }
+            auto settings = readOptions(options);
+            Enumerator enumerator(puzzle, layoutFor(settings));
+            *count = enumerator.count(limit, std::max(1, static_cast<int>(settings.threads)));
+        });
+    }
+
+    int sudoku_generate(uint8_t puzzle[81], int maxGivens, uint64_t seed, const sudoku_options * options) {
+        return guard([&]() {
+            if (puzzle == nullptr) {
+                throw std::invalid_argument("Missing buffer.");
+            }
+            auto settings = readOptions(options);
+            auto layout = layoutFor(settings);
+            std::mt19937_64 random(seed);
+            uint8_t grid[81] = {};
+            int cellIds[81];
+            for (int cellId = 0; cellId < 81; cellId++) {
+                cellIds[cellId] = cellId;
+            }
+
+            // Seed a few random values so the full grid the solver fills in
+            // differs from call to call.
+            std::shuffle(cellIds, cellIds + 81, random);
+            for (int i = 0; i < 11; i++) {
+                int values[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+                std::shuffle(values, values + 9, random);
+                for (auto value : values) {
+                    grid[cellIds[i]] = value;
+                    Enumerator enumerator(grid, layout);
+                    if (enumerator.valid() && enumerator.count(1) == 1) {
+                        break;
+                    }
+                    grid[cellIds[i]] = 0;
+                }
+            }
+            Enumerator enumerator(grid, layout);
+            if (enumerator.solve(grid) != 1) {
+                throw std::runtime_error("Could not generate a new Suduko board.");
+            }
+
+            // Clear cells in random order as long as the solution stays unique.
+            std::shuffle(cellIds, cellIds + 81, random);
+            int givens = 81;
+            for (int i = 0; i < 81 && givens > std::max(maxGivens, 0); i++) {
+                uint8_t value = grid[cellIds[i]];
+                grid[cellIds[i]] = 0;
+                Enumerator check(grid, layout);
+                if (check.count(2) == 1) {
+                    givens--;
+                }
+                else {
+                    grid[cellIds[i]] = value;
+                }
+            }
+            std::memcpy(puzzle, grid, 81);
+        });
+    }
+
+    int sudoku_solve_batch(const uint8_t * puzzles, uint8_t * solutions, uint8_t * solved, size_t count, const sudoku_options * options) {
+        return guard([&]() {
+            if (count > 0 && (puzzles == nullptr || solutions == nullptr || solved == nullptr)) {
+                throw std::invalid_argument("Missing buffer.");
+            }
+            if (std::find_if(puzzles, puzzles + count * 81, [](uint8_t value) { return value > 9; }) != puzzles + count * 81) {
+                throw std::invalid_argument("Invalid value set.");
+            }
+            auto settings = readOptions(options);
+            auto layout = layoutFor(settings);
+            size_t threads = std::min<size_t>(std::max(1, static_cast<int>(settings.threads)), (count + LaneSolver::Lanes - 1) / LaneSolver::Lanes);
+            if (threads <= 1) {
+                solveRange(puzzles, solutions, solved, count, layout);
+                return;
+            }
+
+            // Split into one range per thread, in whole groups of lanes.
+            size_t groups = (count + LaneSolver::Lanes - 1) / LaneSolver::Lanes;
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            try {
+                for (size_t i = 0; i < threads; i++) {
+                    size_t first = std::min(count, groups * i / threads * LaneSolver::Lanes);
+                    size_t last = std::min(count, groups * (i + 1) / threads * LaneSolver::Lanes);
+                    workers.emplace_back(solveRange, puzzles + first * 81, solutions + first * 81, solved + first, last - first, layout);
+                }
+            }
+            catch (...) {
+                // Threads that did start still write into the caller's
+                // buffers, so they finish before the error is returned.
+                // Destroying them joinable would terminate the process.
+                for (auto & worker : workers) {
+                    worker.join();
+                }
+                throw;
+            }
+            for (auto & worker : workers) {
+                worker.join();
+            }
+        });
+    }
+}
@@ -0,0 +1,87 @@
+/*
+C interface to the Suduko solver for use from other languages and processes.
+
+Boards are passed in compact form in caller owned buffers: 81 bytes in row
+major order holding the values 1-9, with 0 for an unset cell. Calls keep
+their working state on the stack and do not allocate, except for calls that
+use jigsaw regions or more than one thread.
+
+Every function returns SUDOKU_OK or a negative SUDOKU_ERROR_* code and never
+lets an exception escape.
+*/
+#ifndef SUDUKO_API_H
+#define SUDUKO_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(SUDOKU_BUILD_DLL)
+#define SUDOKU_API __declspec(dllexport)
+#elif defined(SUDOKU_USE_DLL)
+#define SUDOKU_API __declspec(dllimport)
+#else
+#define SUDOKU_API
+#endif
+#else
+#define SUDOKU_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a function or sudoku_options changes incompatibly.
+#define SUDOKU_ABI_VERSION 1
+
+#define SUDOKU_OK 0
+#define SUDOKU_ERROR_INVALID_ARGUMENT -1
+#define SUDOKU_ERROR_INTERNAL -2
+
+// Extra units on top of the rows, columns and boxes (or jigsaw regions).
+#define SUDOKU_VARIANT_X 1
+#define SUDOKU_VARIANT_WINDOKU 2
+
+typedef struct sudoku_options {
+    // sizeof(sudoku_options) as seen by the caller, so fields can be added
+    // at the end without breaking older callers.
+    uint32_t size;
+
+    // SUDOKU_VARIANT_* flags.
+    uint32_t variants;
+
+    // 81 region numbers 0-8 replacing the boxes, or NULL for standard boxes.
+    const uint8_t * regions;
+
+    // Threads to use for sudoku_count and sudoku_solve_batch, 0 or 1 for the
+    // calling thread only.
+    int32_t threads;
+} sudoku_options;
+
+// Fills options with the defaults: standard layout on the calling thread.
+SUDOKU_API void sudoku_default_options(sudoku_options * options);
+
+SUDOKU_API int sudoku_abi_version(void);
+
+// Solves a puzzle into solution. *solved is set to 1 when a solution was
+// found and 0 when the puzzle has none. options may be NULL.
+SUDOKU_API int sudoku_solve(const uint8_t puzzle[81], uint8_t solution[81], int * solved, const sudoku_options * options);
+
+// Counts the solutions of a puzzle, stopping at limit. A limit of 2 tells
+// if a puzzle has a unique solution.
+SUDOKU_API int sudoku_count(const uint8_t puzzle[81], uint64_t limit, uint64_t * count, const sudoku_options * options);
+
+// Generates a puzzle with a unique solution and at most maxGivens set
+// cells, or as few as could be reached from a random full grid. The same
+// seed gives the same puzzle.
+SUDOKU_API int sudoku_generate(uint8_t puzzle[81], int maxGivens, uint64_t seed, const sudoku_options * options);
+
+// Solves count puzzles stored back to back, 81 bytes each, into solutions.
+// solved[i] is set to 1 or 0 for each puzzle.
+SUDOKU_API int sudoku_solve_batch(const uint8_t * puzzles, uint8_t * solutions, uint8_t * solved, size_t count, const sudoku_options * options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
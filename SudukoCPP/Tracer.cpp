@@ -0,0 +1,242 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Tracer
+    //========================================================================
+
+    Tracer::Tracer(size_t capacity) :
+        m_events(capacity < 1 ? 1 : capacity),
+        m_next(0),
+        m_recorded(0),
+        m_origin(std::chrono::steady_clock::now())
+    {}
+
+    int64_t Tracer::now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin).count();
+    }
+
+    void Tracer::node(int node, int parent, int depth, int cellId, int value, int64_t start) {
+        record(Event{ Node, start, now() - start, node, parent, depth, cellId, value, nullptr, false });
+    }
+
+    void Tracer::rule(int node, const char * rule, bool updated, int64_t start) {
+        record(Event{ Rule, start, now() - start, node, -1, 0, -1, 0, rule, updated });
+    }
+
+    void Tracer::contradiction(int node, const char * rule) {
+        record(Event{ Contradiction, now(), 0, node, -1, 0, -1, 0, rule, false });
+    }
+
+    void Tracer::solution(int node) {
+        record(Event{ Solution, now(), 0, node, -1, 0, -1, 0, nullptr, false });
+    }
+
+    void Tracer::record(const Event & event) {
+        m_events[m_next] = event;
+        m_next = (m_next + 1) % m_events.size();
+        m_recorded++;
+    }
+
+    std::vector<Tracer::Event> Tracer::events() {
+        std::vector<Event> ordered;
+        if (m_recorded > m_events.size()) {
+            ordered.insert(ordered.end(), m_events.begin() + m_next, m_events.end());
+        }
+        ordered.insert(ordered.end(), m_events.begin(), m_events.begin() + (m_recorded > m_events.size() ? m_next : m_recorded));
+
+        // Node events are recorded when the node is done, order by start time.
+        std::stable_sort(ordered.begin(), ordered.end(), [](const Event & a, const Event & b) {
+            return a.start < b.start;
+        });
+        return ordered;
+    }
+
+    uint64_t Tracer::dropped() {
+        return m_recorded > m_events.size() ? m_recorded - m_events.size() : 0;
+    }
+
+    void Tracer::exportChromeTrace(FILE * file) {
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        for (auto & event : events()) {
+            fprintf(file, first ? "" : ",\n");
+            first = false;
+
+            double ts = event.start / 1000.0;
+            double dur = event.duration / 1000.0;
+            switch (event.type) {
+            case Node:
+                if (event.cellId < 0) {
+                    fprintf(file, "{\"name\":\"root\"");
+                }
+                else {
+                    fprintf(file, "{\"name\":\"r%dc%d=%d\"", event.cellId / 9, event.cellId % 9, event.value);
+                }
+                fprintf(file, ",\"cat\":\"node\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                    "\"args\":{\"node\":%d,\"parent\":%d,\"depth\":%d}}",
+                    ts, dur, event.node, event.parent, event.depth);
+                break;
+            case Rule:
+                fprintf(file, "{\"name\":\"%s\",\"cat\":\"rule\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                    "\"args\":{\"node\":%d,\"updated\":%s}}",
+                    event.rule, ts, dur, event.node, event.updated ? "true" : "false");
+                break;
+            case Contradiction:
+                fprintf(file, "{\"name\":\"contradiction\",\"cat\":\"contradiction\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                    "\"args\":{\"node\":%d,\"rule\":\"%s\"}}",
+                    ts, event.node, event.rule);
+                break;
+            case Solution:
+                fprintf(file, "{\"name\":\"solution\",\"cat\":\"solution\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                    "\"args\":{\"node\":%d}}",
+                    ts, event.node);
+                break;
+            }
+        }
+        fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu}}\n",
+            static_cast<unsigned long long>(dropped()));
+    }
+
+    std::string Tracer::summary(size_t top) {
+        struct RuleStats {
+            uint64_t calls = 0;
+            uint64_t updates = 0;
+            uint64_t contradictions = 0;
+            int64_t time = 0;
+        };
+        struct NodeStats {
+            Event event{};
+            bool recorded = false;
+            int64_t subtreeTime = 0;
+            uint64_t subtreeNodes = 0;
+            uint64_t contradictions = 0;
+        };
+
+        std::map<std::string, RuleStats> rules;
+        std::map<std::string, uint64_t> contradictions;
+        std::map<int, NodeStats> nodes;
+        uint64_t solutions = 0;
+        int maxDepth = 0;
+
+        auto all = events();
+        for (auto & event : all) {
+            switch (event.type) {
+            case Node:
+                nodes[event.node].event = event;
+                nodes[event.node].recorded = true;
+                maxDepth = std::max(maxDepth, event.depth);
+                break;
+            case Rule: {
+                auto & stats = rules[event.rule];
+                stats.calls++;
+                stats.updates += event.updated ? 1 : 0;
+                stats.time += event.duration;
+                break;
+            }
+            case Contradiction:
+                contradictions[event.rule]++;
+                nodes[event.node].contradictions++;
+                break;
+            case Solution:
+                solutions++;
+                break;
+            }
+        }
+
+        // Contradictions found by a rule count towards that rule. The others
+        // come from the search itself, such as an empty cell or a value that
+        // could not be set, and are listed on their own.
+        std::map<std::string, uint64_t> searchContradictions;
+        for (auto & pair : contradictions) {
+            auto rule = rules.find(pair.first);
+            if (rule != rules.end()) {
+                rule->second.contradictions += pair.second;
+            }
+            else {
+                searchContradictions[pair.first] += pair.second;
+            }
+        }
+
+        // Only nodes with a node event count as search nodes. A contradiction
+        // whose node event was dropped adds an entry without one.
+        size_t nodeCount = 0;
+        size_t contradictionNodes = 0;
+        for (auto & pair : nodes) {
+            if (pair.second.recorded) {
+                nodeCount++;
+                contradictionNodes += (pair.second.contradictions > 0) ? 1 : 0;
+            }
+        }
+
+        // Children always have higher node ids than their parents, so a
+        // reverse walk rolls every subtree up into its parent.
+        for (auto iter = nodes.rbegin(); iter != nodes.rend(); ++iter) {
+            auto & stats = iter->second;
+            stats.subtreeTime += stats.event.duration;
+            stats.subtreeNodes++;
+            auto parent = nodes.find(stats.event.parent);
+            if (stats.recorded && parent != nodes.end()) {
+                parent->second.subtreeTime += stats.subtreeTime;
+                parent->second.subtreeNodes += stats.subtreeNodes;
+                parent->second.contradictions += stats.contradictions;
+            }
+        }
+
+        std::string text;
+        char line[256];
+        snprintf(line, sizeof(line), "Search: %zu nodes, max depth %d, %llu solutions, %llu events dropped.\n",
+            nodeCount, maxDepth, static_cast<unsigned long long>(solutions), static_cast<unsigned long long>(dropped()));
+        text += line;
+        snprintf(line, sizeof(line), "Contradictions: %zu nodes", contradictionNodes);
+        text += line;
+        for (auto & pair : searchContradictions) {
+            snprintf(line, sizeof(line), ", %llu %s", static_cast<unsigned long long>(pair.second), pair.first.c_str());
+            text += line;
+        }
+        text += ".\n";
+
+        text += "Rules:\n";
+        for (auto & pair : rules) {
+            snprintf(line, sizeof(line), "  %-24s %10llu calls %10llu updates %8llu contradictions %10.3f ms\n",
+                pair.first.c_str(),
+                static_cast<unsigned long long>(pair.second.calls),
+                static_cast<unsigned long long>(pair.second.updates),
+                static_cast<unsigned long long>(pair.second.contradictions),
+                pair.second.time / 1e6);
+            text += line;
+        }
+
+        std::vector<NodeStats *> heaviest;
+        for (auto & pair : nodes) {
+            if (pair.second.recorded && pair.second.event.parent >= 0) {
+                heaviest.push_back(&pair.second);
+            }
+        }
+        size_t count = std::min(top, heaviest.size());
+        std::partial_sort(heaviest.begin(), heaviest.begin() + count, heaviest.end(), [](NodeStats * a, NodeStats * b) {
+            return a->subtreeTime > b->subtreeTime;
+        });
+
+        text += "Heaviest subtrees:\n";
+        for (size_t i = 0; i < count; i++) {
+            auto & stats = *heaviest[i];
+            snprintf(line, sizeof(line), "  node %-8d depth %-3d r%dc%d=%d %10.3f ms %8llu nodes %8llu contradictions\n",
+                stats.event.node, stats.event.depth,
+                stats.event.cellId / 9, stats.event.cellId % 9, stats.event.value,
+                stats.subtreeTime / 1e6,
+                static_cast<unsigned long long>(stats.subtreeNodes),
+                static_cast<unsigned long long>(stats.contradictions));
+            text += line;
+        }
+        return text;
+    }
+};
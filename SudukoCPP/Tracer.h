@@ -0,0 +1,96 @@
+/*
+Search tracing for profiling hard puzzles.
+
+A Tracer attached to a Solver records search nodes, rule runs, contradictions
+and solutions with timestamps into a fixed size ring buffer. The events can be
+exported as Chrome trace event JSON (chrome://tracing, Perfetto) or summarized
+as the heaviest subtrees of the search.
+*/
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    //========================================================================
+    // Class: Tracer
+    //========================================================================
+
+    class Tracer {
+    public:
+        enum EventType { Node, Rule, Contradiction, Solution };
+
+        struct Event {
+            EventType type;
+
+            // Start time in nanoseconds since the tracer was created.
+            int64_t start;
+
+            // Duration in nanoseconds, 0 for instant events.
+            int64_t duration;
+
+            // Search node the event belongs to.
+            int node;
+
+            // Node: parent node, -1 for the root.
+            int parent;
+
+            // Node: depth in the search tree.
+            int depth;
+
+            // Node: the cell id and value tried, -1 for the root.
+            int cellId;
+            int value;
+
+            // Rule and Contradiction: name of the rule or check that failed.
+            // Must point to a string with static storage.
+            const char * rule;
+
+            // Rule: did the rule update the board?
+            bool updated;
+        };
+
+    private:
+        std::vector<Event> m_events;
+        size_t m_next;
+        uint64_t m_recorded;
+        std::chrono::steady_clock::time_point m_origin;
+
+    public:
+        Tracer(size_t capacity = 1 << 20);
+
+        // Nanoseconds since the tracer was created.
+        int64_t now();
+
+        void node(int node, int parent, int depth, int cellId, int value, int64_t start);
+
+        void rule(int node, const char * rule, bool updated, int64_t start);
+
+        void contradiction(int node, const char * rule);
+
+        void solution(int node);
+
+        // The retained events, oldest first.
+        std::vector<Event> events();
+
+        // Number of events lost because the ring buffer wrapped.
+        uint64_t dropped();
+
+        // Writes the events as Chrome trace event JSON.
+        void exportChromeTrace(FILE * file);
+
+        // Describes where the search spent its time: totals per rule and
+        // the top heaviest subtrees.
+        std::string summary(size_t top = 10);
+
+    private:
+        void record(const Event & event);
+    };
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "Verify.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Suduko {
+
+    namespace {
+
+        // Results for one slice of a block of lines.
+        struct SliceResult {
+            uint64_t lines;
+            uint64_t checked;
+            uint64_t failed;
+            std::vector<uint64_t> failedLines;
+        };
+
+        void verifySlice(const char * begin, const char * end, size_t maxFailedLines, const Layout * layout, SliceResult & result) {
+            result = SliceResult{ 0, 0, 0, {} };
+            const char * line = begin;
+            while (line < end) {
+                const char * lineEnd = static_cast<const char *>(std::memchr(line, '\n', end - line));
+                if (lineEnd == nullptr) {
+                    lineEnd = end;
+                }
+                size_t length = lineEnd - line;
+                if (length > 0 && line[length - 1] == '\r') {
+                    length--;
+                }
+                result.lines++;
+
+                if (length > 0 && ((line[0] >= '0' && line[0] <= '9') || line[0] == '.')) {
+                    result.checked++;
+                    if (length < 163 || !verifySolution(line, line + 82, *layout)) {
+                        result.failed++;
+                        if (result.failedLines.size() < maxFailedLines) {
+                            result.failedLines.push_back(result.lines);
+                        }
+                    }
+                }
+                line = lineEnd + 1;
+            }
+        }
+    }
+
+    bool verifySolution(const char * puzzle, const char * solution, const Layout & layout) {
+        uint16_t unitMasks[Layout::MaxUnits] = {};
+        bool mismatch = false;
+
+        for (int cellId = 0; cellId < 81; cellId++) {
+            unsigned digit = static_cast<unsigned char>(solution[cellId]) - '1';
+            if (digit > 8) {
+                return false;
+            }
+            char given = puzzle[cellId];
+            mismatch |= (given >= '1' && given <= '9' && given != solution[cellId]);
+
+            uint16_t bit = 1 << digit;
+            const int * units = layout.cellUnits(cellId);
+            for (int i = 0, count = layout.cellUnitCount(cellId); i < count; i++) {
+                unitMasks[units[i]] |= bit;
+            }
+        }
+
+        // With 9 values per unit a full mask means no value repeats.
+        uint16_t all = 0x1FF;
+        for (int unitNo = 0; unitNo < layout.unitCount(); unitNo++) {
+            all &= unitMasks[unitNo];
+        }
+        return !mismatch && all == 0x1FF;
+    }
+
+    VerifyReport verifyFile(const std::string & filePath, int threads, size_t maxFailedLines, const Layout & layout) {
+        const size_t blockSize = 64 << 20;
+
+        FILE * file = fopen(filePath.c_str(), "rb");
+        if (file == nullptr) {
+            throw std::invalid_argument(std::string("Could not open file: ") + filePath);
+        }
+
+        VerifyReport report{ 0, {}, 0 };
+        uint64_t lineBase = 0;
+        std::vector<char> buffer(blockSize);
+        size_t carry = 0;
+        threads = std::max(1, threads);
+
+        while (true) {
+            size_t read = fread(buffer.data() + carry, 1, buffer.size() - carry, file);
+            size_t filled = carry + read;
+            bool atEnd = read == 0 || feof(file);
+            if (filled == 0) {
+                break;
+            }
+
+            // Only whole lines are checked, the rest is carried to the next block.
+            size_t end = filled;
+            if (!atEnd) {
+                while (end > 0 && buffer[end - 1] != '\n') {
+                    end--;
+                }
+                if (end == 0) {
+                    end = filled;
+                }
+            }
+
+            // Split the block into one slice per thread on line boundaries.
+            std::vector<const char *> bounds{ buffer.data() };
+            for (int i = 1; i < threads; i++) {
+                const char * split = std::max<const char *>(bounds.back(), buffer.data() + end * i / threads);
+                const char * newline = static_cast<const char *>(std::memchr(split, '\n', buffer.data() + end - split));
+                bounds.push_back(newline == nullptr ? buffer.data() + end : newline + 1);
+            }
+            bounds.push_back(buffer.data() + end);
+
+            std::vector<SliceResult> results(threads);
+            std::vector<std::thread> workers;
+            for (int i = 1; i < threads; i++) {
+                workers.push_back(std::thread(verifySlice, bounds[i], bounds[i + 1], maxFailedLines, &layout, std::ref(results[i])));
+            }
+            verifySlice(bounds[0], bounds[1], maxFailedLines, &layout, results[0]);
+            for (auto & worker : workers) {
+                worker.join();
+            }
+
+            for (auto & result : results) {
+                report.checked += result.checked;
+                report.failed += result.failed;
+                for (auto line : result.failedLines) {
+                    if (report.failedLines.size() < maxFailedLines) {
+                        report.failedLines.push_back(lineBase + line);
+                    }
+                }
+                lineBase += result.lines;
+            }
+
+            carry = filled - end;
+            std::memmove(buffer.data(), buffer.data() + end, carry);
+            if (atEnd && carry == 0) {
+                break;
+            }
+        }
+
+        fclose(file);
+        return report;
+    }
+};
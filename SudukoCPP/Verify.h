@@ -0,0 +1,40 @@
+/*
+Bulk verification of puzzle solutions.
+
+Input files hold one pair per line: the puzzle as 81 characters, a single
+separator character and then the solution as 81 characters. In the puzzle
+1-9 are set values and any other character is an unset cell.
+*/
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "Layout.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Suduko {
+
+    struct VerifyReport {
+        // Number of pairs checked.
+        uint64_t checked;
+
+        // Line numbers, starting at 1, of the pairs that failed. Only the
+        // first few failures are kept, see verifyFile().
+        std::vector<uint64_t> failedLines;
+
+        // Total number of pairs that failed.
+        uint64_t failed;
+    };
+
+    // Checks that the solution is a complete valid grid for the layout that
+    // keeps every value set in the puzzle. Both are given as 81 characters.
+    bool verifySolution(const char * puzzle, const char * solution, const Layout & layout = *Layout::standard());
+
+    // Checks every pair in a file. Lines that do not start with a digit or
+    // '.' are skipped so header and comment lines are allowed.
+    VerifyReport verifyFile(const std::string & filePath, int threads, size_t maxFailedLines = 100, const Layout & layout = *Layout::standard());
+};
+
+#endif
@@ -0,0 +1,27 @@
+# Fails the build if a shared library exports anything but the C interface.
+# Run with -DNM=<nm> -DLIBRARY=<file>.
+
+execute_process(
+    COMMAND ${NM} -D --defined-only ${LIBRARY}
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Could not list the symbols of ${LIBRARY}")
+endif()
+
+string(REPLACE "\n" ";" lines "${symbols}")
+set(unexpected "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^[0-9a-fA-F]+ [A-Za-z] (.+)$")
+        set(name "${CMAKE_MATCH_1}")
+        if(NOT name MATCHES "^sudoku_")
+            list(APPEND unexpected "${name}")
+        endif()
+    endif()
+endforeach()
+
+if(unexpected)
+    string(REPLACE ";" "\n  " unexpected "${unexpected}")
+    message(FATAL_ERROR "${LIBRARY} exports symbols outside the C interface:\n  ${unexpected}")
+endif()